@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2012,2014 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2014,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -305,14 +305,14 @@ new_field(int rows, int cols, int frow, int fcol, int nrow, int nbuf)
       New_Field->link = New_Field;
 
 #if USE_WIDEC_SUPPORT
-      New_Field->working = newpad(1, Buffer_Length(New_Field) + 1);
-      New_Field->expanded = typeCalloc(char *, 1 + (unsigned)nbuf);
+      _nc_Init_Expansions(New_Field);
 #endif
 
       if (_nc_Copy_Type(New_Field, &default_field))
 	{
 	  size_t len;
 
+	  New_Field->capacity = Buffer_Length(New_Field);
 	  len = Total_Buffer_Size(New_Field);
 	  if ((New_Field->buf = (FIELD_CELL *)malloc(len)))
 	    {
@@ -343,6 +343,25 @@ new_field(int rows, int cols, int frow, int fcol, int nrow, int nbuf)
   returnField((FIELD *)0);
 }
 
+#if USE_WIDEC_SUPPORT
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  void _nc_Init_Expansions(FIELD *field)
+|
+|   Description   :  Allocate the workspace used to convert the buffers of
+|                    a new field to and from multibyte strings.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Init_Expansions(FIELD *field)
+{
+  field->working = newpad(1, Buffer_Length(field) + 1);
+  field->expanded = typeCalloc(char *, 1 + (unsigned)field->nbuf);
+  field->expanded_ok = typeCalloc(bool, 1 + (unsigned)field->nbuf);
+}
+#endif
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  int free_field( FIELD *field )
@@ -390,8 +409,10 @@ free_field(FIELD *field)
 	  FreeIfNeeded(field->expanded[n]);
 	}
       free(field->expanded);
-      (void)delwin(field->working);
     }
+  FreeIfNeeded(field->expanded_ok);
+  if (field->working != 0)
+    (void)delwin(field->working);
 #endif
   free(field);
   RETURN(E_OK);
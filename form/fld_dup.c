@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2010,2012 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2012,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -69,6 +69,7 @@ dup_field(FIELD *field, int frow, int fcol)
       New_Field->drows = field->drows;
       New_Field->dcols = field->dcols;
       New_Field->maxgrow = field->maxgrow;
+      New_Field->capacity = field->capacity;
       New_Field->nbuf = field->nbuf;
       New_Field->just = field->just;
       New_Field->fore = field->fore;
@@ -77,6 +78,10 @@ dup_field(FIELD *field, int frow, int fcol)
       New_Field->opts = field->opts;
       New_Field->usrptr = field->usrptr;
 
+#if USE_WIDEC_SUPPORT
+      _nc_Init_Expansions(New_Field);
+#endif
+
       if (_nc_Copy_Type(New_Field, field))
 	{
 	  size_t i, len;
@@ -84,7 +89,7 @@ dup_field(FIELD *field, int frow, int fcol)
 	  len = Total_Buffer_Size(New_Field);
 	  if ((New_Field->buf = (FIELD_CELL *)malloc(len)))
 	    {
-	      for (i = 0; i < len; ++i)
+	      for (i = 0; i < len / sizeof(FIELD_CELL); ++i)
 		New_Field->buf[i] = field->buf[i];
 	      returnField(New_Field);
 	    }
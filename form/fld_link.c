@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2010,2012 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2012,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -75,6 +75,7 @@ link_field(FIELD *field, int frow, int fcol)
       New_Field->drows = field->drows;
       New_Field->dcols = field->dcols;
       New_Field->maxgrow = field->maxgrow;
+      New_Field->capacity = field->capacity;
       New_Field->just = field->just;
       New_Field->fore = field->fore;
       New_Field->back = field->back;
@@ -82,6 +83,10 @@ link_field(FIELD *field, int frow, int fcol)
       New_Field->opts = field->opts;
       New_Field->usrptr = field->usrptr;
 
+#if USE_WIDEC_SUPPORT
+      _nc_Init_Expansions(New_Field);
+#endif
+
       if (_nc_Copy_Type(New_Field, field))
 	returnField(New_Field);
     }
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2004,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -58,6 +58,7 @@ set_field_type(FIELD *field, FIELDTYPE *type,...)
 
   Normalize_Field(field);
   _nc_Free_Type(field);
+  ClrStatus(field, _VALIDATED);
 
   field->type = type;
   field->arg = (void *)_nc_Make_Argument(field->type, &ap, &err);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -51,6 +51,10 @@ typedef void *FIELD_CELL;
 #define NCURSES_FIELD_INTERNALS /* nothing */
 #endif
 
+#ifndef NCURSES_FORM_INTERNALS
+#define NCURSES_FORM_INTERNALS /* nothing */
+#endif
+
 typedef int Form_Options;
 typedef int Field_Options;
 
@@ -146,6 +150,11 @@ typedef struct formnode
   void			(*fieldinit)(struct formnode *);
   void			(*fieldterm)(struct formnode *);
 
+  /*
+   * The library keeps an index of the fields for navigation.  It follows
+   * the public members, since only the library allocates forms.
+   */
+  NCURSES_FORM_INTERNALS
 }
 #endif /* !NCURSES_OPAQUE_FORM */
 FORM;
@@ -416,6 +425,8 @@ extern NCURSES_EXPORT(int)	set_field_init (FORM *,Form_Hook);
 extern NCURSES_EXPORT(int)	set_field_term (FORM *,Form_Hook);
 extern NCURSES_EXPORT(int)	post_form (FORM *);
 extern NCURSES_EXPORT(int)	unpost_form (FORM *);
+extern NCURSES_EXPORT(int)	form_begin_update (FORM *);
+extern NCURSES_EXPORT(int)	form_end_update (FORM *);
 extern NCURSES_EXPORT(int)	pos_form_cursor (FORM *);
 extern NCURSES_EXPORT(int)	form_driver (FORM *,int);
 # if NCURSES_WIDECHAR
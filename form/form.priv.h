@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -52,17 +52,25 @@
 
 #define FIELD_CELL NCURSES_CH_T
 
-#define NCURSES_FIELD_INTERNALS char** expanded; WINDOW *working;
-#define NCURSES_FIELD_EXTENSION , (char **)0, (WINDOW *)0
+#define NCURSES_FIELD_INTERNALS char** expanded; WINDOW *working; bool *expanded_ok; \
+	int capacity; int first_mod; int last_mod;
+#define NCURSES_FIELD_EXTENSION , (char **)0, (WINDOW *)0, (bool *)0, 0, -1, -1
 
 #else
 
 #define FIELD_CELL char
 
-#define NCURSES_FIELD_EXTENSION /* nothing */
+#define NCURSES_FIELD_INTERNALS int capacity; int first_mod; int last_mod;
+#define NCURSES_FIELD_EXTENSION , 0, -1, -1
 
 #endif
 
+/* The fields of each page in (row,column) order, and the largest field size,
+   for finding the fields at or near a position. */
+#define NCURSES_FORM_INTERNALS FIELD **sorted; \
+	int max_field_rows; int max_field_cols;
+#define NCURSES_FORM_EXTENSION , (FIELD **)0, 0, 0
+
 #include "form.h"
 
 	/***********************
@@ -76,12 +84,15 @@ extern NCURSES_EXPORT_VAR(FIELDTYPE *) _nc_Default_FieldType;
 #define _OVLMODE         (0x04U) /* Form is in overlay mode                */
 #define _WINDOW_MODIFIED (0x10U) /* Current field window has been modified */
 #define _FCHECK_REQUIRED (0x20U) /* Current field needs validation         */
+#define _UPDATE_DEFERRED (0x40U) /* Fields are redrawn by form_end_update */
 
 /* field status values */
 #define _CHANGED         (0x01U) /* Field has been changed                 */
 #define _NEWTOP          (0x02U) /* Vertical scrolling occurred            */
 #define _NEWPAGE         (0x04U) /* field begins new page of form          */
 #define _MAY_GROW        (0x08U) /* dynamic field may still grow           */
+#define _VALIDATED       (0x10U) /* buffer unchanged since it was checked  */
+#define _DISPLAY_DEFERRED (0x20U) /* field must be redrawn at update end  */
 
 /* fieldtype status values */
 #define _LINKED_TYPE     (0x01U) /* Type is a linked type                  */
@@ -120,9 +131,10 @@ extern NCURSES_EXPORT_VAR(FIELDTYPE *) _nc_Default_FieldType;
 /* Calculate the size for a single buffer for this field */
 #define Buffer_Length(field) ((field)->drows * (field)->dcols)
 
-/* Calculate the total size of all buffers for this field */
+/* Calculate the total size of all buffers for this field.  Each buffer has
+   room for capacity cells, which may be more than its length if it grew. */
 #define Total_Buffer_Size(field) \
-   ( (size_t)(Buffer_Length(field) + 1) * (size_t)(1+(field)->nbuf) * sizeof(FIELD_CELL) )
+   ( (size_t)((field)->capacity + 1) * (size_t)(1+(field)->nbuf) * sizeof(FIELD_CELL) )
 
 /* Logic to determine whether or not a field is single lined */
 #define Single_Line_Field(field) \
@@ -183,6 +195,7 @@ extern NCURSES_EXPORT(void) _nc_Free_Type (FIELD *);
 
 extern NCURSES_EXPORT(int) _nc_Synchronize_Attributes (FIELD*);
 extern NCURSES_EXPORT(int) _nc_Synchronize_Options (FIELD*, Field_Options);
+extern NCURSES_EXPORT(int) _nc_Display_Deferred_Fields (FORM*);
 extern NCURSES_EXPORT(int) _nc_Set_Form_Page (FORM*, int, FIELD*);
 extern NCURSES_EXPORT(int) _nc_Refresh_Current_Field (FORM*);
 extern NCURSES_EXPORT(FIELD *) _nc_First_Active_Field (FORM*);
@@ -223,6 +236,7 @@ extern NCURSES_EXPORT(void) _nc_get_fieldbuffer(FORM*, FIELD*, FIELD_CELL*);
 
 #if USE_WIDEC_SUPPORT
 extern NCURSES_EXPORT(wchar_t *) _nc_Widen_String(char *, int *);
+extern NCURSES_EXPORT(void) _nc_Init_Expansions(FIELD *);
 #endif
 
 #ifdef TRACE
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2010,2012 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2012,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -59,56 +59,36 @@ static FORM default_form =
   NULL,				/* formterm   */
   NULL,				/* fieldinit  */
   NULL				/* fieldterm  */
+  NCURSES_FORM_EXTENSION
 };
 
 NCURSES_EXPORT_VAR(FORM *) _nc_Default_Form = &default_form;
 
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform  
-|   Function      :  static FIELD *Insert_Field_By_Position(
-|                                     FIELD *new_field, 
-|                                     FIELD *head )
+|   Function      :  static int Compare_Positions(const void *a,
+|                                                const void *b)
 |   
-|   Description   :  Insert new_field into sorted fieldlist with head "head"
-|                    and return new head of sorted fieldlist. Sorting
-|                    criteria is (row,column). This is a circular list.
+|   Description   :  qsort() comparison of two fields by page, then by
+|                    (row,column).  Fields at the same position are
+|                    ordered last one in the fields array first.
 |
-|   Return Values :  New head of sorted fieldlist
+|   Return Values :  Negative, zero or positive like strcmp()
 +--------------------------------------------------------------------------*/
-static FIELD *
-Insert_Field_By_Position(FIELD *newfield, FIELD *head)
+static int
+Compare_Positions(const void *a, const void *b)
 {
-  FIELD *current, *newhead;
-
-  assert(newfield);
-
-  if (!head)
-    {				/* empty list is trivial */
-      newhead = newfield->snext = newfield->sprev = newfield;
-    }
-  else
-    {
-      newhead = current = head;
-      while ((current->frow < newfield->frow) ||
-	     ((current->frow == newfield->frow) &&
-	      (current->fcol < newfield->fcol)))
-	{
-	  current = current->snext;
-	  if (current == head)
-	    {			/* We cycled through. Reset head to indicate that */
-	      head = (FIELD *)0;
-	      break;
-	    }
-	}
-      /* we leave the loop with current pointing to the field after newfield */
-      newfield->snext = current;
-      newfield->sprev = current->sprev;
-      newfield->snext->sprev = newfield;
-      newfield->sprev->snext = newfield;
-      if (current == head)
-	newhead = newfield;
-    }
-  return (newhead);
+  const FIELD *f = *(FIELD *const *)a;
+  const FIELD *g = *(FIELD *const *)b;
+  int result = f->page - g->page;
+
+  if (result == 0)
+    result = f->frow - g->frow;
+  if (result == 0)
+    result = f->fcol - g->fcol;
+  if (result == 0)
+    result = g->index - f->index;
+  return result;
 }
 
 /*---------------------------------------------------------------------------
@@ -138,6 +118,9 @@ Disconnect_Fields(FORM *form)
       if (form->page)
 	free(form->page);
       form->page = (_PAGE *) 0;
+      if (form->sorted)
+	free(form->sorted);
+      form->sorted = (FIELD **)0;
     }
 }
 
@@ -194,6 +177,10 @@ Connect_Fields(FORM *form, FIELD **fields)
   else
     RETURN(E_SYSTEM_ERROR);
 
+  if ((form->sorted = typeMalloc(FIELD *, field_cnt)) == (FIELD **)0)
+    RETURN(E_SYSTEM_ERROR);
+  form->max_field_rows = form->max_field_cols = 0;
+
   /* Cycle through fields and calculate page boundaries as well as
      size of the form */
   for (j = 0; j < field_cnt; j++)
@@ -217,33 +204,44 @@ Connect_Fields(FORM *form, FIELD **fields)
 	form->rows = (short) maximum_row_in_field;
       if (form->cols < maximum_col_in_field)
 	form->cols = (short) maximum_col_in_field;
+      if (form->max_field_rows < fields[j]->rows)
+	form->max_field_rows = fields[j]->rows;
+      if (form->max_field_cols < fields[j]->cols)
+	form->max_field_cols = fields[j]->cols;
     }
 
   pg->pmax = (short) (field_cnt - 1);
   form->maxfield = (short) field_cnt;
   form->maxpage = (short) page_nr;
 
-  /* Sort fields on form pages */
+  /* Sort fields on form pages.  Each page keeps the same range of
+     indices in the sorted array as in the fields array. */
   for (page_nr = 0; page_nr < form->maxpage; page_nr++)
     {
-      FIELD *fld = (FIELD *)0;
-
       for (j = form->page[page_nr].pmin; j <= form->page[page_nr].pmax; j++)
 	{
 	  fields[j]->index = (short) j;
 	  fields[j]->page = (short) page_nr;
-	  fld = Insert_Field_By_Position(fields[j], fld);
-	}
-      if (fld)
-	{
-	  form->page[page_nr].smin = fld->index;
-	  form->page[page_nr].smax = fld->sprev->index;
+	  form->sorted[j] = fields[j];
 	}
-      else
+    }
+  qsort(form->sorted, (size_t) field_cnt, sizeof(FIELD *), Compare_Positions);
+
+  /* Link the sorted fields of each page into a circular list */
+  for (page_nr = 0; page_nr < form->maxpage; page_nr++)
+    {
+      int pmin = form->page[page_nr].pmin;
+      int pmax = form->page[page_nr].pmax;
+
+      for (j = pmin; j <= pmax; j++)
 	{
-	  form->page[page_nr].smin = 0;
-	  form->page[page_nr].smax = 0;
+	  FIELD *fld = form->sorted[j];
+
+	  fld->snext = form->sorted[(j == pmax) ? pmin : j + 1];
+	  fld->sprev = form->sorted[(j == pmin) ? pmax : j - 1];
 	}
+      form->page[page_nr].smin = form->sorted[pmin]->index;
+      form->page[page_nr].smax = form->sorted[pmax]->index;
     }
   RETURN(E_OK);
 }
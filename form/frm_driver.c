@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -132,7 +132,7 @@ static int FE_Delete_Previous(FORM *);
 
 /* Calculate start address for the fields buffer# N */
 #define Address_Of_Nth_Buffer(field,N) \
-  ((field)->buf + (N)*(1+Buffer_Length(field)))
+  ((field)->buf + (N)*(1+(field)->capacity))
 
 /* Calculate the start address of the row in the fields specified buffer# N */
 #define Address_Of_Row_In_Nth_Buffer(field,N,row) \
@@ -535,42 +535,57 @@ Buffer_To_Window(const FIELD *field, WINDOW *win)
 
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
-|   Function      :  void _nc_get_fieldbuffer(
+|   Function      :  static void Get_Field_Rows(
 |                                          WINDOW * win,
 |                                          FIELD  * field,
-|                                          FIELD_CELL * buf)
+|                                          FIELD_CELL * buf,
+|                                          int first, int last)
 |
-|   Description   :  Copy the content of the window into the buffer.
-|                    The multiple lines of a window are simply
-|                    concatenated into the buffer. Pad characters in
+|   Description   :  Copy the rows first..last of the window into the
+|                    corresponding rows of the buffer. Pad characters in
 |                    the window will be replaced by blanks in the buffer.
+|                    Only the buffer after the last row read is terminated,
+|                    so the rows which follow are not disturbed. The cursor
+|                    is left on the last row, as if all rows were read.
 |
 |   Return Values :  -
 +--------------------------------------------------------------------------*/
-NCURSES_EXPORT(void)
-_nc_get_fieldbuffer(FORM *form, FIELD *field, FIELD_CELL *buf)
+static void
+Get_Field_Rows(WINDOW *win, FIELD *field, FIELD_CELL *buf, int first, int last)
 {
   int pad;
   int len = 0;
   FIELD_CELL *p;
+  FIELD_CELL next;
   int row, height;
-  WINDOW *win;
-
-  assert(form && field && buf);
-
-  win = form->w;
-  assert(win);
+  bool more;
+
+  height = Minimum(getmaxy(win), field->drows);
+  if (first < 0)
+    first = 0;
+  if (last >= height)
+    last = height - 1;
+  if (first > last)
+    {
+      wmove(win, height - 1, 0);
+      return;
+    }
 
   pad = field->pad;
-  p = buf;
-  height = getmaxy(win);
+  p = buf + Position_Of_Row_In_Buffer(field, first);
+  more = (last + 1 < height);
+  if (more)
+    next = p[(last + 1 - first) * field->dcols];
+  else
+    next = myZEROS;
 
-  for (row = 0; (row < height) && (row < field->drows); row++)
+  for (row = first; row <= last; row++)
     {
       wmove(win, row, 0);
       len += myINNSTR(win, p + len, field->dcols);
     }
-  p[len] = myZEROS;
+  p[len] = next;
+  wmove(win, height - 1, 0);
 
   /* replace visual padding character by blanks in buffer */
   if (pad != C_BLANK)
@@ -591,9 +606,10 @@ _nc_get_fieldbuffer(FORM *form, FIELD *field, FIELD_CELL *buf)
 
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
-|   Function      :  static void Window_To_Buffer(
-|                                          FORM   * form,
-|                                          FIELD  * field)
+|   Function      :  void _nc_get_fieldbuffer(
+|                                          WINDOW * win,
+|                                          FIELD  * field,
+|                                          FIELD_CELL * buf)
 |
 |   Description   :  Copy the content of the window into the buffer.
 |                    The multiple lines of a window are simply
@@ -602,10 +618,143 @@ _nc_get_fieldbuffer(FORM *form, FIELD *field, FIELD_CELL *buf)
 |
 |   Return Values :  -
 +--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_get_fieldbuffer(FORM *form, FIELD *field, FIELD_CELL *buf)
+{
+  assert(form && field && buf);
+  assert(form->w);
+
+  Get_Field_Rows(form->w, field, buf, 0, field->drows - 1);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static void Rows_Modified(FIELD *field,
+|                                              int first, int last)
+|
+|   Description   :  Add the rows first..last to the range of rows of the
+|                    window for the current field which may differ from
+|                    its buffer.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Rows_Modified(FIELD *field, int first, int last)
+{
+  if (field->first_mod < 0 || field->first_mod > first)
+    field->first_mod = first;
+  if (field->last_mod < last)
+    field->last_mod = last;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static void Note_Touched_Rows(FORM *form)
+|
+|   Description   :  Add the touched lines of the window for the current
+|                    field to the range of rows which may differ from its
+|                    buffer. This must be done before the window is
+|                    untouched, since every change to the window touches
+|                    the lines which it alters.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Note_Touched_Rows(FORM *form)
+{
+  WINDOW *win = form->w;
+  int first = 0;
+  int last = getmaxy(win) - 1;
+
+  while (first <= last && !is_linetouched(win, first))
+    first++;
+  if (first <= last)
+    {
+      while (!is_linetouched(win, last))
+	last--;
+      Rows_Modified(form->current, first, last);
+    }
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static void Untouch_Field_Window(FORM *form)
+|
+|   Description   :  Mark the window for the current field as unchanged,
+|                    remembering which rows were changed.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Untouch_Field_Window(FORM *form)
+{
+  Note_Touched_Rows(form);
+  untouchwin(form->w);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static void Buffer_Changed(FIELD *field, int buffer)
+|
+|   Description   :  Note that the given buffer of the field, or all of them
+|                    if buffer is negative, has changed.  A change to the
+|                    field's value means it must be validated again, and in
+|                    the wide-character configuration the multibyte string
+|                    made by field_buffer() is out of date.  Linked fields
+|                    share the buffers, so they are marked as well.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Buffer_Changed(FIELD *field, int buffer)
+{
+  FIELD *f = field;
+
+  do
+    {
+      if (buffer <= 0)
+	ClrStatus(f, _VALIDATED);
+#if USE_WIDEC_SUPPORT
+      if (f->expanded_ok != 0)
+	{
+	  int n;
+
+	  for (n = 0; n <= f->nbuf; ++n)
+	    {
+	      if (buffer < 0 || buffer == n)
+		f->expanded_ok[n] = FALSE;
+	    }
+	}
+#endif
+      f = f->link;
+    }
+  while (f != field);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static void Window_To_Buffer(
+|                                          FORM   * form,
+|                                          FIELD  * field)
+|
+|   Description   :  Copy the content of the window into the buffer.
+|                    Only the rows which may have changed since the last
+|                    copy are read, so editing a long field does not
+|                    copy all of it each time.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
 static void
 Window_To_Buffer(FORM *form, FIELD *field)
 {
-  _nc_get_fieldbuffer(form, field, field->buf);
+  Note_Touched_Rows(form);
+  if (field->first_mod >= 0)
+    {
+      Get_Field_Rows(form->w, field, field->buf,
+		     field->first_mod, field->last_mod);
+      field->first_mod = field->last_mod = -1;
+    }
+  Buffer_Changed(field, 0);
 }
 
 /*---------------------------------------------------------------------------
@@ -631,16 +780,83 @@ Synchronize_Buffer(FORM *form)
     }
 }
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static bool Reserve_Buffers(FIELD *field, int cells)
+|
+|   Description   :  Make room for at least the given number of cells in
+|                    each buffer of a growable field. The room is doubled
+|                    rather than increased by just what is needed, so that
+|                    a field which grows repeatedly is copied only a few
+|                    times. Linked fields share the new buffers.
+|
+|   Return Values :  TRUE     - there is enough room
+|                    FALSE    - the buffers could not be reallocated
++--------------------------------------------------------------------------*/
+static bool
+Reserve_Buffers(FIELD *field, int cells)
+{
+  int old_capacity = field->capacity;
+
+  if (cells > old_capacity)
+    {
+      int capacity = cells;
+      FIELD_CELL *newbuf;
+      FIELD *linked_field;
+      int i;
+
+      if (old_capacity > cells / 2 && old_capacity < INT_MAX / 2)
+	capacity = 2 * old_capacity;
+      if (field->maxgrow)
+	{
+	  int limit = (Single_Line_Field(field)
+		       ? field->maxgrow
+		       : field->maxgrow * field->dcols);
+
+	  capacity = Maximum(cells, Minimum(capacity, limit));
+	}
+
+      newbuf = (FIELD_CELL *)realloc(field->buf,
+				     (size_t)(capacity + 1)
+				     * (size_t)(1 + field->nbuf)
+				     * sizeof(FIELD_CELL));
+      if (newbuf == 0)
+	return FALSE;
+
+      T((T_CREATE("fieldcell %p"), (void *)newbuf));
+
+      /* the first buffer stays in place; move the others, last first,
+       * since they may overlap their new places.
+       */
+      for (i = field->nbuf; i > 0; i--)
+	{
+	  memmove(newbuf + i * (1 + capacity),
+		  newbuf + i * (1 + old_capacity),
+		  (size_t)(1 + old_capacity) * sizeof(FIELD_CELL));
+	}
+
+      linked_field = field;
+      do
+	{
+	  linked_field->buf = newbuf;
+	  linked_field->capacity = capacity;
+	  linked_field = linked_field->link;
+	}
+      while (linked_field != field);
+    }
+  return TRUE;
+}
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  static bool Field_Grown( FIELD *field, int amount)
 |
 |   Description   :  This function is called for growable dynamic fields
-|                    only. It has to increase the buffers and to allocate
-|                    a new window for this field.
-|                    This function has the side effect to set a new
-|                    field-buffer pointer, the dcols and drows values
-|                    as well as a new current Window for the field.
+|                    only. It has to increase the buffers and to resize
+|                    the current window for this field.
+|                    This function has the side effect to set new dcols
+|                    and drows values, and possibly a new field-buffer
+|                    pointer and a new current window for the field.
 |
 |   Return Values :  TRUE     - field successfully increased
 |                    FALSE    - there was some error
@@ -657,8 +873,6 @@ Field_Grown(FIELD *field, int amount)
       int new_buflen;
       int old_dcols = field->dcols;
       int old_drows = field->drows;
-      FIELD_CELL *oldbuf = field->buf;
-      FIELD_CELL *newbuf;
 
       int growth;
       FORM *form = field->form;
@@ -689,8 +903,7 @@ Field_Grown(FIELD *field, int amount)
 	}
       /* drows, dcols changed, so we get really the new buffer length */
       new_buflen = Buffer_Length(field);
-      newbuf = (FIELD_CELL *)malloc(Total_Buffer_Size(field));
-      if (!newbuf)
+      if (!Reserve_Buffers(field, new_buflen))
 	{
 	  /* restore to previous state */
 	  field->dcols = old_dcols;
@@ -701,38 +914,41 @@ Field_Grown(FIELD *field, int amount)
 	}
       else
 	{
-	  /* Copy all the buffers.  This is the reason why we can't just use
-	   * realloc().
+	  /* The new cells follow the old ones in each buffer, since either
+	   * the field has a single line, or only its number of rows grows.
 	   */
 	  int i, j;
-	  FIELD_CELL *old_bp;
-	  FIELD_CELL *new_bp;
+	  FIELD_CELL *bp;
 
 	  result = TRUE;	/* allow sharing of recovery on failure */
 
-	  T((T_CREATE("fieldcell %p"), (void *)newbuf));
-	  field->buf = newbuf;
 	  for (i = 0; i <= field->nbuf; i++)
 	    {
-	      new_bp = Address_Of_Nth_Buffer(field, i);
-	      old_bp = oldbuf + i * (1 + old_buflen);
-	      for (j = 0; j < old_buflen; ++j)
-		new_bp[j] = old_bp[j];
-	      while (j < new_buflen)
-		new_bp[j++] = myBLANK;
-	      new_bp[new_buflen] = myZEROS;
+	      bp = Address_Of_Nth_Buffer(field, i);
+	      for (j = old_buflen; j < new_buflen; ++j)
+		bp[j] = myBLANK;
+	      bp[new_buflen] = myZEROS;
 	    }
 
-#if USE_WIDEC_SUPPORT && NCURSES_EXT_FUNCS
-	  if (wresize(field->working, 1, Buffer_Length(field) + 1) == ERR)
-	    result = FALSE;
-#endif
-
-	  if (need_visual_update && result)
+	  if (need_visual_update)
 	    {
-	      WINDOW *new_window = newpad(field->drows, field->dcols);
+	      WINDOW *new_window;
 
-	      if (new_window != 0)
+#if NCURSES_EXT_FUNCS
+	      /* A pad can simply be resized, keeping its contents */
+	      if (form->w != 0 && form->w->_parent == 0)
+		{
+		  if (wresize(form->w, field->drows, field->dcols) == OK)
+		    {
+		      Untouch_Field_Window(form);
+		      wmove(form->w, form->currow, form->curcol);
+		    }
+		  else
+		    result = FALSE;
+		}
+	      else
+#endif
+	      if ((new_window = newpad(field->drows, field->dcols)) != 0)
 		{
 		  assert(form != (FORM *)0);
 		  if (form->w)
@@ -741,7 +957,7 @@ Field_Grown(FIELD *field, int amount)
 		  Set_Field_Window_Attributes(field, form->w);
 		  werase(form->w);
 		  Buffer_To_Window(field, form->w);
-		  untouchwin(form->w);
+		  Untouch_Field_Window(form);
 		  wmove(form->w, form->currow, form->curcol);
 		}
 	      else
@@ -750,7 +966,7 @@ Field_Grown(FIELD *field, int amount)
 
 	  if (result)
 	    {
-	      free(oldbuf);
+	      Buffer_Changed(field, -1);
 	      /* reflect changes in linked fields */
 	      if (field != field->link)
 		{
@@ -760,7 +976,6 @@ Field_Grown(FIELD *field, int amount)
 		       linked_field != field;
 		       linked_field = linked_field->link)
 		    {
-		      linked_field->buf = field->buf;
 		      linked_field->drows = field->drows;
 		      linked_field->dcols = field->dcols;
 		    }
@@ -768,16 +983,19 @@ Field_Grown(FIELD *field, int amount)
 	    }
 	  else
 	    {
-	      /* restore old state */
+	      /* restore old state; the buffers keep their new room */
 	      field->dcols = old_dcols;
 	      field->drows = old_drows;
-	      field->buf = oldbuf;
+	      for (i = 0; i <= field->nbuf; i++)
+		{
+		  bp = Address_Of_Nth_Buffer(field, i);
+		  bp[old_buflen] = myZEROS;
+		}
 	      if ((single_line_field &&
 		   (field->dcols != field->maxgrow)) ||
 		  (!single_line_field &&
 		   (field->drows != field->maxgrow)))
 		SetStatus(field, _MAY_GROW);
-	      free(newbuf);
 	    }
 	}
     }
@@ -985,7 +1203,7 @@ _nc_Refresh_Current_Field(FORM *form)
       if (is_public)
 	wsyncup(form->w);
     }
-  untouchwin(form->w);
+  Untouch_Field_Window(form);
   returnCode(_nc_Position_Form_Cursor(form));
 }
 
@@ -1179,6 +1397,32 @@ Display_Or_Erase_Field(FIELD *field, bool bEraseFlag)
 #define Display_Field(field) Display_Or_Erase_Field(field,FALSE)
 #define Erase_Field(field)   Display_Or_Erase_Field(field,TRUE)
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static int Display_Or_Defer(
+|                                           FIELD * field,
+|                                           bool bEraseFlag)
+|
+|   Description   :  Display or erase a field which has changed, unless
+|                    its form is between form_begin_update() and
+|                    form_end_update().  Then only note that the field
+|                    must be redrawn when the update ends, so that a field
+|                    changed several times is drawn once.
+|
+|   Return Values :  E_OK           - on success
+|                    E_SYSTEM_ERROR - some error (typical no memory)
++--------------------------------------------------------------------------*/
+static int
+Display_Or_Defer(FIELD *field, bool bEraseFlag)
+{
+  if (field->form != 0 && (field->form->status & _UPDATE_DEFERRED))
+    {
+      SetStatus(field, _DISPLAY_DEFERRED);
+      return E_OK;
+    }
+  return Display_Or_Erase_Field(field, bEraseFlag);
+}
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  static int Synchronize_Field(FIELD * field)
@@ -1216,7 +1460,7 @@ Synchronize_Field(FIELD *field)
 	  res = _nc_Refresh_Current_Field(form);
 	}
       else
-	res = Display_Field(field);
+	res = Display_Or_Defer(field, FALSE);
     }
   SetStatus(field, _CHANGED);
   return (res);
@@ -1316,7 +1560,7 @@ _nc_Synchronize_Attributes(FIELD *field)
 	}
       else
 	{
-	  res = Display_Field(field);
+	  res = Display_Or_Defer(field, FALSE);
 	}
     }
   CHECKPOS(form);
@@ -1355,6 +1599,10 @@ _nc_Synchronize_Options(FIELD *field, Field_Options newopts)
   field->opts = newopts;
   form = field->form;
 
+  /* whether a blank field is valid depends on O_NULLOK */
+  if ((unsigned)changed_opts & O_NULLOK)
+    ClrStatus(field, _VALIDATED);
+
   if (form)
     {
       if (form->status & _POSTED)
@@ -1369,15 +1617,15 @@ _nc_Synchronize_Options(FIELD *field, Field_Options newopts)
 	      if ((unsigned)changed_opts & O_VISIBLE)
 		{
 		  if ((unsigned)newopts & O_VISIBLE)
-		    res = Display_Field(field);
+		    res = Display_Or_Defer(field, FALSE);
 		  else
-		    res = Erase_Field(field);
+		    res = Display_Or_Defer(field, TRUE);
 		}
 	      else
 		{
 		  if (((unsigned)changed_opts & O_PUBLIC) &&
 		      ((unsigned)newopts & O_VISIBLE))
-		    res = Display_Field(field);
+		    res = Display_Or_Defer(field, FALSE);
 		}
 	    }
 	}
@@ -1399,7 +1647,7 @@ _nc_Synchronize_Options(FIELD *field, Field_Options newopts)
 	      (field->just != NO_JUSTIFICATION) &&
 	      Field_Really_Appears(field))
 	    {
-	      res2 = Display_Field(field);
+	      res2 = Display_Or_Defer(field, FALSE);
 	    }
 	}
       else
@@ -1416,7 +1664,7 @@ _nc_Synchronize_Options(FIELD *field, Field_Options newopts)
 		  (field->just != NO_JUSTIFICATION) &&
 		  Field_Really_Appears(field))
 		{
-		  res2 = Display_Field(field);
+		  res2 = Display_Or_Defer(field, FALSE);
 		}
 	    }
 	}
@@ -1427,6 +1675,49 @@ _nc_Synchronize_Options(FIELD *field, Field_Options newopts)
   returnCode(res);
 }
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  int _nc_Display_Deferred_Fields(FORM * form)
+|
+|   Description   :  Redraw each field whose display was deferred while
+|                    updates of the form were batched, once, as it is now.
+|                    The current field is skipped, since its window was
+|                    made from its buffer when it became current.
+|
+|   Return Values :  E_OK             - success
+|                    E_SYSTEM_ERROR   - some severe basic error
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+_nc_Display_Deferred_Fields(FORM *form)
+{
+  int res = E_OK;
+  int n;
+
+  T((T_CALLED("_nc_Display_Deferred_Fields(%p)"), (void *)form));
+
+  for (n = 0; form->field != 0 && n < form->maxfield; ++n)
+    {
+      FIELD *field = form->field[n];
+
+      if (field->status & _DISPLAY_DEFERRED)
+	{
+	  int res2 = E_OK;
+
+	  ClrStatus(field, _DISPLAY_DEFERRED);
+	  if (field == form->current)
+	    continue;
+	  if (Field_Really_Appears(field))
+	    res2 = Display_Field(field);
+	  else if ((form->status & _POSTED)
+		   && (field->page == form->curpage))
+	    res2 = Erase_Field(field);
+	  if (res2 != E_OK && res == E_OK)
+	    res = res2;
+	}
+    }
+  returnCode(res);
+}
+
 /*
  * Removes the focus from the current field of the form.
  */
@@ -1553,6 +1844,9 @@ _nc_Set_Current_Field(FORM *form, FIELD *newfield)
 	}
 
       untouchwin(form->w);
+      /* read all of the window when the buffer is next synchronized */
+      field->first_mod = 0;
+      field->last_mod = field->drows - 1;
     }
 
   form->currow = form->curcol = form->toprow = form->begincol = 0;
@@ -2421,6 +2715,8 @@ Insert_String(FORM *form, int row, FIELD_CELL *txt, int len)
   int datalen = (int)(After_End_Of_Data(bp, field->dcols) - bp);
   int freelen = field->dcols - datalen;
   int requiredlen = len + 1;
+  /* the text is part of the buffer, which may move if the field grows */
+  int offset = (int)(txt - field->buf);
   FIELD_CELL *split;
   int result = E_REQUEST_DENIED;
 
@@ -2442,6 +2738,7 @@ Insert_String(FORM *form, int row, FIELD_CELL *txt, int len)
 	    return (E_SYSTEM_ERROR);
 	  /* !!!Side-Effect : might be changed due to growth!!! */
 	  bp = Address_Of_Row_In_Buffer(field, row);
+	  txt = field->buf + offset;
 	}
 
       if (row < (field->drows - 1))
@@ -2460,6 +2757,7 @@ Insert_String(FORM *form, int row, FIELD_CELL *txt, int len)
 
 	  if ((result = Insert_String(form, row + 1, split, freelen)) == E_OK)
 	    {
+	      txt = field->buf + offset;
 	      wmove(form->w, row, datalen);
 	      wclrtoeol(form->w);
 	      wmove(form->w, row, 0);
@@ -3215,11 +3513,40 @@ Check_Field(FORM *form, FIELDTYPE *typ, FIELD *field, TypeArgument *argp)
   return TRUE;
 }
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static bool Check_Is_Repeatable(FIELDTYPE * typ)
+|
+|   Description   :  Check whether the result of validating a field with
+|                    this fieldtype depends only on the field's buffer and
+|                    options, so that it need not be validated again while
+|                    those are unchanged.  This is true of the built-in
+|                    types, but the check routines of an application's
+|                    types may look at anything.
+|
+|   Return Values :  TRUE       - the check may be skipped if unchanged
+|                    FALSE      - the check must always be made
++--------------------------------------------------------------------------*/
+static bool
+Check_Is_Repeatable(FIELDTYPE *typ)
+{
+  if (typ)
+    {
+      if (typ->status & _LINKED_TYPE)
+	return (Check_Is_Repeatable(typ->left) &&
+		Check_Is_Repeatable(typ->right));
+      return (typ->status & _RESIDENT) ? TRUE : FALSE;
+    }
+  return TRUE;
+}
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  bool _nc_Internal_Validation(FORM * form )
 |
-|   Description   :  Validate the current field of the form.
+|   Description   :  Validate the current field of the form.  A field of
+|                    a built-in type which has not changed since it was
+|                    last found valid is not checked again.
 |
 |   Return Values :  TRUE  - field is valid
 |                    FALSE - field is invalid
@@ -3235,8 +3562,15 @@ _nc_Internal_Validation(FORM *form)
   if ((form->status & _FCHECK_REQUIRED) ||
       (!(Field_Has_Option(field, O_PASSOK))))
     {
-      if (!Check_Field(form, field->type, field, (TypeArgument *)(field->arg)))
-	return FALSE;
+      if (!(field->status & _VALIDATED))
+	{
+	  if (!Check_Field(form, field->type, field,
+			   (TypeArgument *)(field->arg)))
+	    return FALSE;
+	  /* the check may have changed the buffer, so note this afterwards */
+	  if (Check_Is_Repeatable(field->type))
+	    SetStatus(field, _VALIDATED);
+	}
       ClrStatus(form, _FCHECK_REQUIRED);
       SetStatus(field, _CHANGED);
       Synchronize_Linked_Fields(field);
@@ -3443,6 +3777,99 @@ Sorted_Previous_Field(FIELD *field)
   return (field_on_page);
 }
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static int Sorted_Lower_Bound(const FORM * form,
+|                                                 const _PAGE * pg,
+|                                                 int row,
+|                                                 int col)
+|
+|   Description   :  Find the first field of the page at or after the
+|                    position (row,column) in the sorted fields of the form,
+|                    by binary search.
+|
+|   Return Values :  Index into form->sorted, pmax+1 if there is none.
++--------------------------------------------------------------------------*/
+static int
+Sorted_Lower_Bound(const FORM *form, const _PAGE * pg, int row, int col)
+{
+  int lo = pg->pmin;
+  int hi = pg->pmax + 1;
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      const FIELD *field = form->sorted[mid];
+
+      if (field->frow < row || (field->frow == row && field->fcol < col))
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static int Sorted_Position(const FIELD * field)
+|
+|   Description   :  Find the field in the sorted fields of its form.
+|
+|   Return Values :  Index into form->sorted
++--------------------------------------------------------------------------*/
+static int
+Sorted_Position(const FIELD *field)
+{
+  const FORM *form = field->form;
+  int n = Sorted_Lower_Bound(form, &form->page[field->page],
+			     field->frow, field->fcol);
+
+  /* step over other fields at the same position */
+  while (form->sorted[n] != field)
+    ++n;
+  return n;
+}
+
+#ifdef NCURSES_MOUSE_VERSION
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  static FIELD *Field_At(FORM *form, int ry, int rx)
+|
+|   Description   :  Find the selectable field on the current page which
+|                    encloses the given coordinates.  Only the fields
+|                    whose position is near enough, given the size of the
+|                    largest field, are checked.  If fields overlap, the
+|                    first in the form's field array is chosen.
+|
+|   Return Values :  Pointer to the field, NULL if there is none.
++--------------------------------------------------------------------------*/
+static FIELD *
+Field_At(FORM *form, int ry, int rx)
+{
+  const _PAGE *pg = &form->page[form->curpage];
+  FIELD *result = (FIELD *)0;
+  int row;
+
+  for (row = Maximum(ry - form->max_field_rows + 1, 0); row <= ry; ++row)
+    {
+      int n = Sorted_Lower_Bound(form, pg, row, rx - form->max_field_cols + 1);
+
+      for (; n <= pg->pmax; ++n)
+	{
+	  FIELD *field = form->sorted[n];
+
+	  if (field->frow != row || field->fcol > rx)
+	    break;
+	  if ((result == 0 || field->index < result->index)
+	      && Field_Is_Selectable(field)
+	      && Field_encloses(field, ry, rx) == E_OK)
+	    result = field;
+	}
+    }
+  return (result);
+}
+#endif
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  static FIELD *Left_Neighbor_Field(FIELD * field)
@@ -3452,23 +3879,27 @@ Sorted_Previous_Field(FIELD *field)
 |
 |   Return Values :  Pointer to left neighbor field.
 +--------------------------------------------------------------------------*/
-NCURSES_INLINE static FIELD *
+static FIELD *
 Left_Neighbor_Field(FIELD *field)
 {
-  FIELD *field_on_page = field;
-
-  /* For a field that has really a left neighbor, the while clause
-     immediately fails and the loop is left, positioned at the right
-     neighbor. Otherwise we cycle backwards through the sorted field list
-     until we enter the same line (from the right end).
+  FORM *form = field->form;
+  const _PAGE *pg = &form->page[field->page];
+  int pos = Sorted_Position(field);
+  int first = Sorted_Lower_Bound(form, pg, field->frow, 0);
+  int last = Sorted_Lower_Bound(form, pg, field->frow + 1, 0) - 1;
+  int n;
+
+  /* The line is a range of the sorted fields.  Look left of the field,
+     then cycle to the right end of the line, as walking backwards
+     through the sorted field list would.
    */
-  do
-    {
-      field_on_page = Sorted_Previous_Field(field_on_page);
-    }
-  while (field_on_page->frow != field->frow);
-
-  return (field_on_page);
+  for (n = pos - 1; n >= first; --n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  for (n = last; n > pos; --n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  return (field);
 }
 
 /*---------------------------------------------------------------------------
@@ -3480,19 +3911,24 @@ Left_Neighbor_Field(FIELD *field)
 |
 |   Return Values :  Pointer to right neighbor field.
 +--------------------------------------------------------------------------*/
-NCURSES_INLINE static FIELD *
+static FIELD *
 Right_Neighbor_Field(FIELD *field)
 {
-  FIELD *field_on_page = field;
+  FORM *form = field->form;
+  const _PAGE *pg = &form->page[field->page];
+  int pos = Sorted_Position(field);
+  int first = Sorted_Lower_Bound(form, pg, field->frow, 0);
+  int last = Sorted_Lower_Bound(form, pg, field->frow + 1, 0) - 1;
+  int n;
 
   /* See the comments on Left_Neighbor_Field to understand how it works */
-  do
-    {
-      field_on_page = Sorted_Next_Field(field_on_page);
-    }
-  while (field_on_page->frow != field->frow);
-
-  return (field_on_page);
+  for (n = pos + 1; n <= last; ++n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  for (n = first; n < pos; ++n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  return (field);
 }
 
 /*---------------------------------------------------------------------------
@@ -3511,38 +3947,52 @@ Right_Neighbor_Field(FIELD *field)
 static FIELD *
 Upper_Neighbor_Field(FIELD *field)
 {
-  FIELD *field_on_page = field;
-  int frow = field->frow;
+  FORM *form = field->form;
+  const _PAGE *pg = &form->page[field->page];
   int fcol = field->fcol;
-
-  /* Walk back to the 'previous' line. The second term in the while clause
-     just guarantees that we stop if we cycled through the line because
-     there might be no 'previous' line if the page has just one line.
+  int pos = Sorted_Position(field);
+  int first = Sorted_Lower_Bound(form, pg, field->frow, 0);
+  int last = Sorted_Lower_Bound(form, pg, field->frow + 1, 0) - 1;
+  int found = -1;
+  int n;
+
+  /* Walk back to the 'previous' line, skipping the rest of this line,
+     but stopping at another field in the same column of this line.
+     If there is no 'previous' line, because the page has just one
+     line, we cycle through the line.
    */
-  do
-    {
-      field_on_page = Sorted_Previous_Field(field_on_page);
-    }
-  while (field_on_page->frow == frow && field_on_page->fcol != fcol);
-
-  if (field_on_page->frow != frow)
+  for (n = pos - 1; n >= first && form->sorted[n]->fcol == fcol; --n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  for (n = first - 1; n >= pg->pmin && found < 0; --n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      found = n;
+  for (n = pg->pmax; n > last && found < 0; --n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      found = n;
+
+  if (found >= 0)
     {
       /* We really found a 'previous' line. We are positioned at the
-         rightmost field on this line */
-      frow = field_on_page->frow;
-
-      /* We walk to the left as long as we are really right of the
-         field. */
-      while (field_on_page->frow == frow && field_on_page->fcol > fcol)
-	field_on_page = Sorted_Previous_Field(field_on_page);
-
-      /* If we wrapped, just go to the right which is the first field on
-         the row */
-      if (field_on_page->frow != frow)
-	field_on_page = Sorted_Next_Field(field_on_page);
+         rightmost field on this line.  Take the rightmost field which
+         is not right of the field, else the first field on the line. */
+      int frow = form->sorted[found]->frow;
+      int start = Sorted_Lower_Bound(form, pg, frow, 0);
+
+      n = Sorted_Lower_Bound(form, pg, frow, fcol + 1) - 1;
+      for (n = Minimum(n, found); n >= start; --n)
+	if (Field_Is_Selectable(form->sorted[n]))
+	  return form->sorted[n];
+      for (n = start; n < found; ++n)
+	if (Field_Is_Selectable(form->sorted[n]))
+	  return form->sorted[n];
+      return form->sorted[found];
     }
 
-  return (field_on_page);
+  for (n = last; n > pos; --n)
+    if (form->sorted[n]->fcol == fcol && Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  return (field);
 }
 
 /*---------------------------------------------------------------------------
@@ -3561,38 +4011,48 @@ Upper_Neighbor_Field(FIELD *field)
 static FIELD *
 Down_Neighbor_Field(FIELD *field)
 {
-  FIELD *field_on_page = field;
-  int frow = field->frow;
+  FORM *form = field->form;
+  const _PAGE *pg = &form->page[field->page];
   int fcol = field->fcol;
-
-  /* Walk forward to the 'next' line. The second term in the while clause
-     just guarantees that we stop if we cycled through the line because
-     there might be no 'next' line if the page has just one line.
-   */
-  do
-    {
-      field_on_page = Sorted_Next_Field(field_on_page);
-    }
-  while (field_on_page->frow == frow && field_on_page->fcol != fcol);
-
-  if (field_on_page->frow != frow)
+  int pos = Sorted_Position(field);
+  int first = Sorted_Lower_Bound(form, pg, field->frow, 0);
+  int last = Sorted_Lower_Bound(form, pg, field->frow + 1, 0) - 1;
+  int found = -1;
+  int n;
+
+  /* See the comments on Upper_Neighbor_Field to understand how it works */
+  for (n = pos + 1; n <= last && form->sorted[n]->fcol == fcol; ++n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  for (n = last + 1; n <= pg->pmax && found < 0; ++n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      found = n;
+  for (n = pg->pmin; n < first && found < 0; ++n)
+    if (Field_Is_Selectable(form->sorted[n]))
+      found = n;
+
+  if (found >= 0)
     {
-      /* We really found a 'next' line. We are positioned at the rightmost
-         field on this line */
-      frow = field_on_page->frow;
-
-      /* We walk to the right as long as we are really left of the
-         field. */
-      while (field_on_page->frow == frow && field_on_page->fcol < fcol)
-	field_on_page = Sorted_Next_Field(field_on_page);
-
-      /* If we wrapped, just go to the left which is the last field on
-         the row */
-      if (field_on_page->frow != frow)
-	field_on_page = Sorted_Previous_Field(field_on_page);
+      /* We really found a 'next' line. We are positioned at the leftmost
+         field on this line.  Take the leftmost field which is not left
+         of the field, else the last field on the line. */
+      int frow = form->sorted[found]->frow;
+      int end = Sorted_Lower_Bound(form, pg, frow + 1, 0) - 1;
+
+      n = Sorted_Lower_Bound(form, pg, frow, fcol);
+      for (n = Maximum(n, found); n <= end; ++n)
+	if (Field_Is_Selectable(form->sorted[n]))
+	  return form->sorted[n];
+      for (n = end; n > found; --n)
+	if (Field_Is_Selectable(form->sorted[n]))
+	  return form->sorted[n];
+      return form->sorted[found];
     }
 
-  return (field_on_page);
+  for (n = first; n < pos; ++n)
+    if (form->sorted[n]->fcol == fcol && Field_Is_Selectable(form->sorted[n]))
+      return form->sorted[n];
+  return (field);
 }
 
 /*----------------------------------------------------------------------------
@@ -4473,30 +4933,20 @@ form_driver(FORM *form, int c)
 		}
 	      else if (wenclose(sub, event.y, event.x))
 		{		/* Inside the area we try to find the hit item */
-		  int i;
-
 		  ry = event.y;
 		  rx = event.x;
 		  if (wmouse_trafo(sub, &ry, &rx, FALSE))
 		    {
-		      int min_field = form->page[form->curpage].pmin;
-		      int max_field = form->page[form->curpage].pmax;
+		      FIELD *field = Field_At(form, ry, rx);
 
-		      for (i = min_field; i <= max_field; ++i)
+		      if (field != 0)
 			{
-			  FIELD *field = form->field[i];
-
-			  if (Field_Is_Selectable(field)
-			      && Field_encloses(field, ry, rx) == E_OK)
-			    {
-			      res = _nc_Set_Current_Field(form, field);
-			      if (res == E_OK)
-				res = _nc_Position_Form_Cursor(form);
-			      if (res == E_OK
-				  && (event.bstate & BUTTON1_DOUBLE_CLICKED))
-				res = E_UNKNOWN_COMMAND;
-			      break;
-			    }
+			  res = _nc_Set_Current_Field(form, field);
+			  if (res == E_OK)
+			    res = _nc_Position_Form_Cursor(form);
+			  if (res == E_OK
+			      && (event.bstate & BUTTON1_DOUBLE_CLICKED))
+			    res = E_UNKNOWN_COMMAND;
 			}
 		    }
 		}
@@ -4675,30 +5125,20 @@ form_driver_w(FORM *form, int type, wchar_t c)
 		}
 	      else if (wenclose(sub, event.y, event.x))
 		{		/* Inside the area we try to find the hit item */
-		  int i;
-
 		  ry = event.y;
 		  rx = event.x;
 		  if (wmouse_trafo(sub, &ry, &rx, FALSE))
 		    {
-		      int min_field = form->page[form->curpage].pmin;
-		      int max_field = form->page[form->curpage].pmax;
+		      FIELD *field = Field_At(form, ry, rx);
 
-		      for (i = min_field; i <= max_field; ++i)
+		      if (field != 0)
 			{
-			  FIELD *field = form->field[i];
-
-			  if (Field_Is_Selectable(field)
-			      && Field_encloses(field, ry, rx) == E_OK)
-			    {
-			      res = _nc_Set_Current_Field(form, field);
-			      if (res == E_OK)
-				res = _nc_Position_Form_Cursor(form);
-			      if (res == E_OK
-				  && (event.bstate & BUTTON1_DOUBLE_CLICKED))
-				res = E_UNKNOWN_COMMAND;
-			      break;
-			    }
+			  res = _nc_Set_Current_Field(form, field);
+			  if (res == E_OK)
+			    res = _nc_Position_Form_Cursor(form);
+			  if (res == E_OK
+			      && (event.bstate & BUTTON1_DOUBLE_CLICKED))
+			    res = E_UNKNOWN_COMMAND;
 			}
 		    }
 		}
@@ -4836,6 +5276,7 @@ set_field_buffer(FIELD *field, int buffer, const char *value)
       p[i] = value[i];
     }
 #endif
+  Buffer_Changed(field, buffer);
 
   if (buffer == 0)
     {
@@ -4851,12 +5292,115 @@ set_field_buffer(FIELD *field, int buffer, const char *value)
   RETURN(res);
 }
 
+#if USE_WIDEC_SUPPORT
+/*---------------------------------------------------------------------------
+| Store the multibyte form of a wide-character in the target, which has room
+| for MB_LEN_MAX bytes.  UTF-8 is encoded directly, since that is the usual
+| case.  Return the number of bytes, or -1 if it cannot be converted.
++--------------------------------------------------------------------------*/
+static int
+Encode_Wide(char *target, wchar_t source, bool utf8)
+{
+  int result = -1;
+
+  if (utf8)
+    {
+      unsigned long ch = (unsigned long)source;
+
+      if (ch < 0x80)
+	{
+	  target[0] = (char)ch;
+	  result = 1;
+	}
+      else if (ch < 0x800)
+	{
+	  target[0] = (char)(0xc0 | (ch >> 6));
+	  target[1] = (char)(0x80 | (ch & 0x3f));
+	  result = 2;
+	}
+      else if (ch < 0x10000)
+	{
+	  if (ch < 0xd800 || ch > 0xdfff)
+	    {
+	      target[0] = (char)(0xe0 | (ch >> 12));
+	      target[1] = (char)(0x80 | ((ch >> 6) & 0x3f));
+	      target[2] = (char)(0x80 | (ch & 0x3f));
+	      result = 3;
+	    }
+	}
+      else if (ch < 0x110000)
+	{
+	  target[0] = (char)(0xf0 | (ch >> 18));
+	  target[1] = (char)(0x80 | ((ch >> 12) & 0x3f));
+	  target[2] = (char)(0x80 | ((ch >> 6) & 0x3f));
+	  target[3] = (char)(0x80 | (ch & 0x3f));
+	  result = 4;
+	}
+    }
+  else
+    {
+      mbstate_t state;
+      size_t check;
+
+      init_mb(state);
+      check = _nc_wcrtomb(target, source, &state);
+      if (check != (size_t) (-1))
+	result = (int)check;
+    }
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+| Convert the cells of a field buffer to a multibyte string, skipping the
+| null-padding and the extensions of multi-column characters.  Cells which
+| cannot be converted are omitted.  If the target is null, only count the
+| bytes needed.
++--------------------------------------------------------------------------*/
+static size_t
+Expand_Buffer(const FIELD_CELL *data, int size, char *target, bool utf8)
+{
+  size_t used = 0;
+  int n;
+
+  for (n = 0; n < size; ++n)
+    {
+      if (!isWidecExt(data[n]) && data[n].chars[0] != L'\0')
+	{
+	  char cell[CCHARW_MAX * MB_LEN_MAX];
+	  int have = 0;
+	  int k;
+
+	  for (k = 0; k < CCHARW_MAX && data[n].chars[k] != L'\0'; ++k)
+	    {
+	      int next = Encode_Wide(cell + have, data[n].chars[k], utf8);
+
+	      if (next < 0)
+		{
+		  have = 0;
+		  break;
+		}
+	      have += next;
+	    }
+	  if (target != 0)
+	    memcpy(target + used, cell, (size_t) have);
+	  used += (size_t) have;
+	}
+    }
+  return used;
+}
+#endif
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform
 |   Function      :  char *field_buffer(const FIELD *field,int buffer)
 |
 |   Description   :  Return the address of the buffer for the field.
 |
+|                    In the wide-character configuration, this is a copy
+|                    of the buffer converted to a multibyte string.  The
+|                    copy is kept until the buffer changes, so repeated
+|                    calls for an unchanged buffer are cheap.
+|
 |   Return Values :  Pointer to buffer or NULL if arguments were invalid.
 +--------------------------------------------------------------------------*/
 NCURSES_EXPORT(char *)
@@ -4869,50 +5413,39 @@ field_buffer(const FIELD *field, int buffer)
   if (field && (buffer >= 0) && (buffer <= field->nbuf))
     {
 #if USE_WIDEC_SUPPORT
-      FIELD_CELL *data = Address_Of_Nth_Buffer(field, buffer);
-      size_t need = 0;
-      int size = Buffer_Length(field);
-      int n;
-
-      /* determine the number of bytes needed to store the expanded string */
-      for (n = 0; n < size; ++n)
+      if (field->expanded != 0 && field->expanded_ok != 0)
 	{
-	  if (!isWidecExt(data[n]) && data[n].chars[0] != L'\0')
+	  if (field->expanded_ok[buffer] && field->expanded[buffer] != 0)
 	    {
-	      mbstate_t state;
-	      size_t next;
-
-	      init_mb(state);
-	      next = _nc_wcrtomb(0, data[n].chars[0], &state);
-	      if (next > 0)
-		need += next;
+	      result = field->expanded[buffer];
 	    }
-	}
-
-      /* allocate a place to store the expanded string */
-      if (field->expanded[buffer] != 0)
-	free(field->expanded[buffer]);
-      field->expanded[buffer] = typeMalloc(char, need + 1);
-
-      /*
-       * Expand the multibyte data.
-       *
-       * It may also be multi-column data.  In that case, the data for a row
-       * may be null-padded to align to the dcols/drows layout (or it may
-       * contain embedded wide-character extensions).  Change the null-padding
-       * to blanks as needed.
-       */
-      if ((result = field->expanded[buffer]) != 0)
-	{
-	  wclear(field->working);
-	  wmove(field->working, 0, 0);
-	  for (n = 0; n < size; ++n)
+	  else
 	    {
-	      if (!isWidecExt(data[n]) && data[n].chars[0] != L'\0')
-		wadd_wch(field->working, &data[n]);
+	      FIELD_CELL *data = Address_Of_Nth_Buffer(field, buffer);
+	      int size = Buffer_Length(field);
+	      bool utf8 = (bool)(_nc_unicode_locale() != 0);
+	      size_t need = Expand_Buffer(data, size, (char *)0, utf8);
+
+	      /* allocate a place to store the expanded string */
+	      if (field->expanded[buffer] != 0)
+		free(field->expanded[buffer]);
+	      field->expanded[buffer] = typeMalloc(char, need + 1);
+
+	      /*
+	       * Expand the multibyte data.
+	       *
+	       * It may also be multi-column data.  In that case, the data for a
+	       * row may be null-padded to align to the dcols/drows layout (or it
+	       * may contain embedded wide-character extensions), which is
+	       * omitted.
+	       */
+	      if ((result = field->expanded[buffer]) != 0)
+		{
+		  (void)Expand_Buffer(data, size, result, utf8);
+		  result[need] = '\0';
+		  field->expanded_ok[buffer] = TRUE;
+		}
 	    }
-	  wmove(field->working, 0, 0);
-	  winnstr(field->working, result, (int)need);
 	}
 #else
       result = Address_Of_Nth_Buffer(field, buffer);
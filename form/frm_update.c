@@ -0,0 +1,88 @@
+/****************************************************************************
+ * Copyright (c) 2020 Free Software Foundation, Inc.                        *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+#include "form.priv.h"
+
+MODULE_ID("$Id: frm_update.c,v 1.1 2020/01/25 00:00:00 tom Exp $")
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  int form_begin_update(FORM * form)
+|
+|   Description   :  Start a batch of changes to the fields of the form.
+|                    Until form_end_update() is called, fields other than
+|                    the current one are not redrawn when their buffers,
+|                    attributes or options change.
+|
+|   Return Values :  E_OK              - success
+|                    E_BAD_ARGUMENT    - invalid form pointer
+|                    E_BAD_STATE       - a batch is already started
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+form_begin_update(FORM *form)
+{
+  T((T_CALLED("form_begin_update(%p)"), (void *)form));
+
+  if (!form)
+    RETURN(E_BAD_ARGUMENT);
+
+  if (form->status & _UPDATE_DEFERRED)
+    RETURN(E_BAD_STATE);
+
+  SetStatus(form, _UPDATE_DEFERRED);
+  RETURN(E_OK);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform
+|   Function      :  int form_end_update(FORM * form)
+|
+|   Description   :  End a batch of changes started by form_begin_update(),
+|                    redrawing each field which changed during it once.
+|
+|   Return Values :  E_OK              - success
+|                    E_BAD_ARGUMENT    - invalid form pointer
+|                    E_BAD_STATE       - no batch was started
+|                    E_SYSTEM_ERROR    - system error
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+form_end_update(FORM *form)
+{
+  T((T_CALLED("form_end_update(%p)"), (void *)form));
+
+  if (!form)
+    RETURN(E_BAD_ARGUMENT);
+
+  if (!(form->status & _UPDATE_DEFERRED))
+    RETURN(E_BAD_STATE);
+
+  ClrStatus(form, _UPDATE_DEFERRED);
+  RETURN(_nc_Display_Deferred_Fields(form));
+}
+
+/* frm_update.c ends here */
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -36,12 +36,20 @@
 
 MODULE_ID("$Id: fty_enum.c,v 1.26 2010/05/01 21:11:07 tom Exp $")
 
+typedef struct
+  {
+    unsigned char *key;		/* keyword as compared, see Make_Key() */
+    int index;			/* position of the keyword in kwds */
+  }
+enumKEY;
+
 typedef struct
   {
     char **kwds;
     int count;
     bool checkcase;
     bool checkunique;
+    enumKEY *keys;		/* the keywords, sorted for lookup */
   }
 enumARG;
 
@@ -53,6 +61,123 @@ typedef struct
   }
 enumParams;
 
+#define SKIP_SPACE(x) while(((*(x))!='\0') && (is_blank(*(x)))) (x)++
+#define NOMATCH 0
+#define PARTIAL 1
+#define EXACT   2
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform  
+|   Function      :  static int Compare_Keys(const void *a, const void *b)
+|   
+|   Description   :  qsort() comparison of two keywords in the index.
+|
+|   Return Values :  Negative, zero or positive like strcmp()
++--------------------------------------------------------------------------*/
+static int
+Compare_Keys(const void *a, const void *b)
+{
+  const enumKEY *p = (const enumKEY *)a;
+  const enumKEY *q = (const enumKEY *)b;
+  int result = strcmp((const char *)p->key, (const char *)q->key);
+
+  if (result == 0)
+    result = p->index - q->index;
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform  
+|   Function      :  static unsigned char *Make_Key(const char * s,
+|                                                    bool ccase)
+|   
+|   Description   :  Copy a keyword in the form in which Compare() matches
+|                    it, i.e., without leading blanks and, unless case is
+|                    significant, in uppercase.
+|
+|   Return Values :  Pointer to the copy or NULL on error
++--------------------------------------------------------------------------*/
+static unsigned char *
+Make_Key(const char *s, bool ccase)
+{
+  const unsigned char *src = (const unsigned char *)s;
+  unsigned char *result;
+
+  SKIP_SPACE(src);
+  if ((result = (unsigned char *)strdup((const char *)src)) != 0
+      && !ccase)
+    {
+      unsigned char *dst;
+
+      for (dst = result; *dst != '\0'; ++dst)
+	*dst = (unsigned char)toupper(*dst);
+    }
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform  
+|   Function      :  static void Free_Enum_Keys(enumARG * argp)
+|   
+|   Description   :  Free the sorted index of the keywords.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Free_Enum_Keys(enumARG *argp)
+{
+  if (argp->keys)
+    {
+      int n;
+
+      for (n = 0; n < argp->count; ++n)
+	free(argp->keys[n].key);
+      free(argp->keys);
+      argp->keys = (enumKEY *) 0;
+    }
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform  
+|   Function      :  static bool Make_Enum_Keys(enumARG * argp)
+|   
+|   Description   :  Build the sorted index of the keywords, which lets
+|                    Check_Enum_Field() find those matching a buffer by
+|                    binary search rather than comparing each of them.
+|
+|   Return Values :  TRUE  - the index was built
+|                    FALSE - out of memory
++--------------------------------------------------------------------------*/
+static bool
+Make_Enum_Keys(enumARG *argp)
+{
+  argp->keys = (enumKEY *) 0;
+  if (argp->count > 0)
+    {
+      int n;
+
+      if (argp->kwds == 0
+	  || (argp->keys = typeCalloc(enumKEY, argp->count)) == 0)
+	return FALSE;
+
+      for (n = 0; n < argp->count; ++n)
+	{
+	  argp->keys[n].index = n;
+	  if (argp->kwds[n] == 0
+	      || (argp->keys[n].key = Make_Key(argp->kwds[n],
+					       argp->checkcase)) == 0)
+	    {
+	      Free_Enum_Keys(argp);
+	      return FALSE;
+	    }
+	}
+      qsort(argp->keys, (size_t) argp->count, sizeof(enumKEY), Compare_Keys);
+    }
+  return TRUE;
+}
+
+static void Free_Enum_Type(void *);
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform  
 |   Function      :  static void *Generic_Enum_Type(void * arg)
@@ -111,6 +236,11 @@ Generic_Enum_Type(void *arg)
 		  *kptarget = (char *)0;
 		}
 	    }
+	  if (!Make_Enum_Keys(argp))
+	    {
+	      Free_Enum_Type(argp);
+	      argp = (enumARG *)0;
+	    }
 	}
     }
   return (void *)argp;
@@ -175,6 +305,11 @@ Copy_Enum_Type(const void *argp)
 		  *kptarget = (char *)0;
 		}
 	    }
+	  if (!Make_Enum_Keys(result))
+	    {
+	      Free_Enum_Type(result);
+	      result = (enumARG *)0;
+	    }
 	}
     }
   return (void *)result;
@@ -193,8 +328,9 @@ Free_Enum_Type(void *argp)
 {
   if (argp)
     {
-      const enumARG *ap = (const enumARG *)argp;
+      enumARG *ap = (enumARG *)argp;
 
+      Free_Enum_Keys(ap);
       if (ap->kwds && ap->count > 0)
 	{
 	  char **kp = ap->kwds;
@@ -212,11 +348,6 @@ Free_Enum_Type(void *argp)
     }
 }
 
-#define SKIP_SPACE(x) while(((*(x))!='\0') && (is_blank(*(x)))) (x)++
-#define NOMATCH 0
-#define PARTIAL 1
-#define EXACT   2
-
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform  
 |   Function      :  static int Compare(const unsigned char * s,  
@@ -272,6 +403,38 @@ Compare(const unsigned char *s, const unsigned char *buf,
   return ((s[-1] != '\0') ? PARTIAL : EXACT);
 }
 
+/*---------------------------------------------------------------------------
+|   Facility      :  libnform  
+|   Function      :  static int Compare_Prefix(const unsigned char * key,
+|                                             const unsigned char * buf,
+|                                             int len,
+|                                             bool ccase)
+|   
+|   Description   :  Compare the first len characters of a keyword from
+|                    the index with those of the text in 'buf', which are
+|                    not blank.  The keywords beginning with that text
+|                    are adjacent in the index, ordered as by strcmp().
+|
+|   Return Values :  Negative - keyword sorts before the text
+|                    0        - keyword begins with the text
+|                    Positive - keyword sorts after the text
++--------------------------------------------------------------------------*/
+static int
+Compare_Prefix(const unsigned char *key, const unsigned char *buf,
+	       int len, bool ccase)
+{
+  int n;
+
+  for (n = 0; n < len; ++n)
+    {
+      int ch = ccase ? buf[n] : toupper(buf[n]);
+
+      if (key[n] != ch)
+	return (key[n] < ch) ? -1 : 1;
+    }
+  return 0;
+}
+
 /*---------------------------------------------------------------------------
 |   Facility      :  libnform  
 |   Function      :  static bool Check_Enum_Field(
@@ -280,48 +443,87 @@ Compare(const unsigned char *s, const unsigned char *buf,
 |   
 |   Description   :  Validate buffer content to be a valid enumeration value
 |
+|                    The result is that of comparing the buffer with each
+|                    keyword in turn using Compare(): the first keyword
+|                    which matches is chosen, unless only uniquely partial
+|                    matches are allowed and it is not an exact one.  The
+|                    sorted index is used to look only at the keywords
+|                    which match.
+|
 |   Return Values :  TRUE  - field is valid
 |                    FALSE - field is invalid
 +--------------------------------------------------------------------------*/
 static bool
 Check_Enum_Field(FIELD *field, const void *argp)
 {
-  char **kwds = ((const enumARG *)argp)->kwds;
-  bool ccase = ((const enumARG *)argp)->checkcase;
-  bool unique = ((const enumARG *)argp)->checkunique;
-  unsigned char *bp = (unsigned char *)field_buffer(field, 0);
-  char *s, *t, *p;
-  int res;
+  const enumARG *ap = (const enumARG *)argp;
+  const enumKEY *keys = ap->keys;
+  bool ccase = ap->checkcase;
+  const unsigned char *bp = (unsigned char *)field_buffer(field, 0);
+  const unsigned char *tail;
+  int len, lo, hi;
+  int first = -1;		/* first keyword matching the buffer */
+  int first_exact = -1;		/* first keyword matching it exactly */
+  int matches = 0;
+
+  if (keys == 0 || bp == 0)
+    return FALSE;
+
+  SKIP_SPACE(bp);
+  tail = bp + strlen((const char *)bp);
+  while (tail != bp && is_blank(tail[-1]))
+    --tail;
+  len = (int)(tail - bp);
+
+  lo = 0;
+  hi = ap->count;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (Compare_Prefix(keys[mid].key, bp, len, ccase) < 0)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
 
-  while (kwds && (s = (*kwds++)))
+  for (; lo < ap->count; ++lo)
     {
-      if ((res = Compare((unsigned char *)s, bp, ccase)) != NOMATCH)
+      const unsigned char *s = keys[lo].key;
+      const unsigned char *t = tail;
+      int index = keys[lo].index;
+
+      if (Compare_Prefix(s, bp, len, ccase) != 0)
+	break;
+      /* an empty buffer matches only empty keywords, which sort first */
+      if (len == 0 && *s != '\0')
+	break;
+
+      /* the keyword matches exactly if the rest of it is blanks which
+         are also in the buffer */
+      for (s += len; *s != '\0' && *s == *t; ++s, ++t)
 	{
-	  p = t = s;		/* t is at least a partial match */
-	  if ((unique && res != EXACT))
-	    {
-	      while (kwds && (p = *kwds++))
-		{
-		  if ((res = Compare((unsigned char *)p, bp, ccase)) != NOMATCH)
-		    {
-		      if (res == EXACT)
-			{
-			  t = p;
-			  break;
-			}
-		      else
-			t = (char *)0;
-		    }
-		}
-	    }
-	  if (t)
-	    {
-	      set_field_buffer(field, 0, t);
-	      return TRUE;
-	    }
-	  if (!p)
-	    break;
+	  ;
 	}
+      if (*s == '\0' && (first_exact < 0 || index < first_exact))
+	first_exact = index;
+      if (first < 0 || index < first)
+	first = index;
+      ++matches;
+    }
+
+  if (first >= 0 && first != first_exact && ap->checkunique)
+    {
+      if (first_exact >= 0)
+	first = first_exact;
+      else if (matches > 1)
+	first = -1;
+    }
+
+  if (first >= 0)
+    {
+      set_field_buffer(field, 0, ap->kwds[first]);
+      return TRUE;
     }
   return FALSE;
 }
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -52,12 +52,15 @@ extern "C"
 #endif
 
   struct panel;			/* Forward Declaration */
+  struct panel_index;		/* Forward Declaration */
 
   struct panelhook
     {
       struct panel *top_panel;
       struct panel *bottom_panel;
       struct panel *stdscr_pseudo_panel;
+      struct panel_index *panel_index;	/* used in update_panels */
+      void (*free_index) (struct panel_index *);	/* for delscreen */
 #if NO_LEAKS
       int (*destroy) (struct panel *);
 #endif
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -192,16 +192,37 @@ extern NCURSES_EXPORT(int) _nc_capcmp (const char *, const char *);
 extern NCURSES_EXPORT(void) _nc_set_writedir (const char *);
 extern NCURSES_EXPORT(void) _nc_write_entry (TERMTYPE2 *const);
 extern NCURSES_EXPORT(int) _nc_write_object (TERMTYPE2 *, char *, unsigned *, unsigned);
+extern NCURSES_EXPORT(void) _nc_write_prepare (TERMTYPE2 *const);
+extern NCURSES_EXPORT(unsigned long) _nc_entry_checksum (TERMTYPE2 *);
 
 /* comp_parse.c: entry list handling */
 extern NCURSES_EXPORT(void) _nc_read_entry_source (FILE*, char*, int, bool, bool (*)(ENTRY*));
+extern NCURSES_EXPORT(void) _nc_read_entry_buffer (const char *, size_t, int, bool, bool (*)(ENTRY*));
 extern NCURSES_EXPORT(bool) _nc_entry_match (char *, char *);
 extern NCURSES_EXPORT(int) _nc_resolve_uses (bool); /* obs 20040705 */
 extern NCURSES_EXPORT(int) _nc_resolve_uses2 (bool, bool);
 extern NCURSES_EXPORT(void) _nc_free_entries (ENTRY *);
+extern NCURSES_EXPORT(void) _nc_discard_entries (void);
 extern NCURSES_IMPEXP void NCURSES_API (*_nc_check_termtype)(TERMTYPE *); /* obs 20040705 */
 extern NCURSES_IMPEXP void NCURSES_API (*_nc_check_termtype2)(TERMTYPE2 *, bool);
 
+/*
+ * comp_source.c: compile terminfo source held in memory, without using the
+ * global entry list or writing to the filesystem.  These are not reentrant;
+ * see tic_source(3X).
+ */
+typedef struct tic_compiled TIC_COMPILED;
+
+#define TIC_LITERAL	1	/* suppress post-processing, like tic -U */
+#define TIC_SILENT	2	/* suppress warnings */
+
+extern NCURSES_EXPORT(TIC_COMPILED *) _nc_compile_source (const char *, size_t, int);
+extern NCURSES_EXPORT(int) _nc_compiled_count (const TIC_COMPILED *);
+extern NCURSES_EXPORT(TERMTYPE2 *) _nc_compiled_entry (const TIC_COMPILED *, int);
+extern NCURSES_EXPORT(TERMTYPE2 *) _nc_compiled_find (const TIC_COMPILED *, const char *);
+extern NCURSES_EXPORT(int) _nc_compiled_image (const TIC_COMPILED *, int, char *, unsigned *, unsigned);
+extern NCURSES_EXPORT(void) _nc_free_compiled (TIC_COMPILED *);
+
 /* trace_xnames.c */
 extern NCURSES_EXPORT(void) _nc_trace_xnames (TERMTYPE *);
 
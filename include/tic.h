@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -124,6 +124,9 @@ extern "C" {
 /* location of user's personal info directory */
 #define PRIVATE_INFO	"%s/.terminfo"	/* plug getenv("HOME") into %s */
 
+/* index of a leaf directory, kept by tic for toe */
+#define DIR_INDEX	".toe-index"
+
 /*
  * Some traces are designed to be used via tic's verbose option (and similar in
  * infocmp and toe) rather than the 'trace()' function.  So we use the bits
@@ -205,6 +208,19 @@ typedef struct {
 	int (*compare_names)(const char *, const char *);
 } HashData;
 
+/*
+ * make_hash also builds a minimal perfect hash of the names in each table, so
+ * that a name is found with a single probe and comparison.  The first hash
+ * of a name selects a seed, and the second, using that seed, its slot.
+ */
+typedef struct {
+	unsigned buckets;		/* number of seeds */
+	unsigned slots;			/* number of entries */
+	unsigned limit;			/* characters of the name hashed, or 0 */
+	const unsigned short *seeds;
+	const HashValue *entries;	/* table-index for each slot, or -1 */
+} PerfectData;
+
 struct alias
 {
 	const char	*from;
@@ -276,6 +292,7 @@ extern NCURSES_EXPORT(char *) _nc_rootname (char *);
 /* comp_captab.c */
 extern NCURSES_EXPORT(const struct name_table_entry *) _nc_get_table (bool);
 extern NCURSES_EXPORT(const HashData *) _nc_get_hash_info (bool);
+extern NCURSES_EXPORT(const PerfectData *) _nc_get_perfect_info (bool);
 extern NCURSES_EXPORT(const struct alias *) _nc_get_alias_table (bool);
 
 /* comp_hash.c: name lookup */
@@ -288,6 +305,7 @@ extern NCURSES_EXPORT(struct user_table_entry const *) _nc_find_user_entry
 extern NCURSES_EXPORT(int)  _nc_get_token (bool);
 extern NCURSES_EXPORT(void) _nc_panic_mode (char);
 extern NCURSES_EXPORT(void) _nc_push_token (int);
+extern NCURSES_EXPORT(void) _nc_reset_source (const char *, size_t);
 extern NCURSES_EXPORT_VAR(int) _nc_curr_col;
 extern NCURSES_EXPORT_VAR(int) _nc_curr_line;
 extern NCURSES_EXPORT_VAR(int) _nc_syntax;
@@ -308,6 +326,19 @@ extern NCURSES_EXPORT(void) _nc_set_type (const char *const);
 extern NCURSES_EXPORT(void) _nc_syserr_abort (const char *const,...) GCC_PRINTFLIKE(1,2) GCC_NORETURN;
 extern NCURSES_EXPORT(void) _nc_warning (const char *const,...) GCC_PRINTFLIKE(1,2);
 extern NCURSES_EXPORT_VAR(bool) _nc_suppress_warnings;
+extern NCURSES_IMPEXP void NCURSES_API (*_nc_err_recovery) (void);
+
+/* comp_parse.c: hashed index of the fields of terminal names */
+typedef struct _name_node {
+    struct _name_node *next;
+    unsigned hashed;
+    unsigned order;		/* position of the entry in its list */
+} NAME_NODE;
+
+extern NCURSES_EXPORT(int) _nc_compare_order (const void *, const void *);
+extern NCURSES_EXPORT(size_t) _nc_field_length (const char *);
+extern NCURSES_EXPORT(unsigned) _nc_hash_name (const char *, size_t);
+extern NCURSES_EXPORT(unsigned) _nc_index_fields (NAME_NODE **, unsigned, NAME_NODE *, const char *, unsigned);
 
 /* comp_scan.c */
 extern NCURSES_EXPORT_VAR(struct token)	_nc_curr_token;
@@ -315,6 +346,7 @@ extern NCURSES_EXPORT_VAR(struct token)	_nc_curr_token;
 /* comp_userdefs.c */
 NCURSES_EXPORT(const struct user_table_entry *) _nc_get_userdefs_table (void);
 NCURSES_EXPORT(const HashData *) _nc_get_hash_user (void);
+NCURSES_EXPORT(const PerfectData *) _nc_get_perfect_user (void);
 
 /* captoinfo.c: capability conversion */
 extern NCURSES_EXPORT(char *) _nc_captoinfo (const char *, const char *, int const);
@@ -356,7 +388,19 @@ extern NCURSES_EXPORT(void) _nc_first_db(DBDIRS *, int *);
 extern NCURSES_EXPORT(void) _nc_last_db(void);
 
 /* write_entry.c */
+typedef struct {
+    char *name;			/* the file's name */
+    char *description;		/* the entry's description, null for an alias */
+    unsigned long checksum;	/* see _nc_entry_checksum() */
+    long size;			/* the file's size and time when recorded */
+    long mtime;
+    unsigned serial;		/* position of the record in the index */
+} DIR_ENTRY;
+
 extern NCURSES_EXPORT(int) _nc_tic_written (void);
+extern NCURSES_EXPORT(DIR_ENTRY *) _nc_read_dir_index (const char *, size_t *);
+extern NCURSES_EXPORT(DIR_ENTRY *) _nc_find_dir_entry (DIR_ENTRY *, size_t, const char *, long, long);
+extern NCURSES_EXPORT(void) _nc_free_dir_index (DIR_ENTRY *, size_t);
 
 #endif /* NCURSES_INTERNALS */
 
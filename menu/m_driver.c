@@ -52,41 +52,59 @@ MODULE_ID("$Id: m_driver.c,v 1.33 2020/01/18 17:02:13 tom Exp $")
 
 /*---------------------------------------------------------------------------
 |   Facility      :  libnmenu
-|   Function      :  static bool Is_Sub_String(
-|                           bool IgnoreCaseFlag,
-|                           const char *part,
-|                           const char *string)
+|   Function      :  static int Match_Next_Character(
+|                           MENU *menu,
+|                           int  ch,
+|                           int  *current)
 |
-|   Description   :  Checks whether or not part is a substring of string.
+|   Description   :  This internal routine is called for a menu positioned
+|                    at an item with three different classes of characters:
+|                       - a printable character; the character is added to
+|                         the current pattern and the next item matching
+|                         this pattern is searched.
+|                       - NUL; the pattern stays as it is and the next item
+|                         matching the pattern is searched
+|                       - BS; the pattern stays as it is and the previous
+|                         item matching the pattern is searched
 |
-|   Return Values :  TRUE   - if it is a substring
-|                    FALSE  - if it is not a substring
+|                       The current parameter contains on call the index of
+|                       the item where the search starts. On return - if
+|                       a match was found - it contains the index of the
+|                       matching item.
+|
+|   Return Values :  E_OK        - an item matching the pattern was found
+|                    E_NO_MATCH  - nothing found
 +--------------------------------------------------------------------------*/
-static bool
-Is_Sub_String(
-	       bool IgnoreCaseFlag,
-	       const char *part,
-	       const char *string
-)
+static int
+Match_Next_Character(MENU * menu, int ch, int *current)
 {
-  assert(part && string);
-  if (IgnoreCaseFlag)
+  int idx;
+
+  if (ch && ch != BS)
     {
-      while (*string && *part)
+      /* if we become to long, we need no further checking : there can't be
+         a match ! */
+      if ((menu->pindex + 1) > menu->namelen)
+	return (E_NO_MATCH);
+
+      Add_Character_To_Pattern(menu, ch);
+      /* with a new pattern the search starts with the actual item. If we
+         do a NEXT_PATTERN or PREV_PATTERN search, we start with the one
+         after or before the actual item. */
+      idx = _nc_Find_Match(menu, *current, 1, TRUE);
+      if (idx < 0)
 	{
-	  if (toupper(UChar(*string++)) != toupper(UChar(*part)))
-	    break;
-	  part++;
+	  /* if we had no match with a new pattern, we have to restore it */
+	  Remove_Character_From_Pattern(menu);
 	}
     }
   else
-    {
-      while (*string && *part)
-	if (*part != *string++)
-	  break;
-      part++;
-    }
-  return ((*part) ? FALSE : TRUE);
+    idx = _nc_Find_Match(menu, *current, (ch == BS) ? -1 : 1, FALSE);
+
+  if (idx < 0)
+    return (E_NO_MATCH);
+  *current = idx;
+  return (E_OK);
 }
 
 /*---------------------------------------------------------------------------
@@ -96,20 +114,11 @@ Is_Sub_String(
 |                           int  ch,
 |                           ITEM **item)
 |
-|   Description   :  This internal routine is called for a menu positioned
-|                    at an item with three different classes of characters:
-|                       - a printable character; the character is added to
-|                         the current pattern and the next item matching
-|                         this pattern is searched.
-|                       - NUL; the pattern stays as it is and the next item
-|                         matching the pattern is searched
-|                       - BS; the pattern stays as it is and the previous
-|                         item matching the pattern is searched
-|
-|                       The item parameter contains on call a pointer to
-|                       the item where the search starts. On return - if
-|                       a match was found - it contains a pointer to the
-|                       matching item.
+|   Description   :  Search for the next item matching the pattern, as
+|                    described for Match_Next_Character(). The item
+|                    parameter contains on call a pointer to the item where
+|                    the search starts. On return - if a match was found -
+|                    it contains a pointer to the matching item.
 |
 |   Return Values :  E_OK        - an item matching the pattern was found
 |                    E_NO_MATCH  - nothing found
@@ -118,8 +127,8 @@ NCURSES_EXPORT(int)
 _nc_Match_Next_Character_In_Item_Name
 (MENU * menu, int ch, ITEM ** item)
 {
-  bool found = FALSE, passed = FALSE;
-  int idx, last;
+  int idx;
+  int result;
 
   T((T_CALLED("_nc_Match_Next_Character(%p,%d,%p)"),
      (void *)menu, ch, (void *)item));
@@ -127,73 +136,36 @@ _nc_Match_Next_Character_In_Item_Name
   assert(menu && item && *item);
   idx = (*item)->index;
 
-  if (ch && ch != BS)
-    {
-      /* if we become to long, we need no further checking : there can't be
-         a match ! */
-      if ((menu->pindex + 1) > menu->namelen)
-	RETURN(E_NO_MATCH);
-
-      Add_Character_To_Pattern(menu, ch);
-      /* we artificially position one item back, because in the do...while
-         loop we start with the next item. This means, that with a new
-         pattern search we always start the scan with the actual item. If
-         we do a NEXT_PATTERN or PREV_PATTERN search, we start with the
-         one after or before the actual item. */
-      if (--idx < 0)
-	idx = menu->nitems - 1;
-    }
-
-  last = idx;			/* this closes the cycle */
+  if ((result = Match_Next_Character(menu, ch, &idx)) == E_OK)
+    *item = menu->items[idx];
+  RETURN(result);
+}
 
-  do
-    {
-      if (ch == BS)
-	{			/* we have to go backward */
-	  if (--idx < 0)
-	    idx = menu->nitems - 1;
-	}
-      else
-	{			/* otherwise we always go forward */
-	  if (++idx >= menu->nitems)
-	    idx = 0;
-	}
-      if (Is_Sub_String((bool)((menu->opt & O_IGNORECASE) != 0),
-			menu->pattern,
-			menu->items[idx]->name.str)
-	)
-	found = TRUE;
-      else
-	passed = TRUE;
-    }
-  while (!found && (idx != last));
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  int _nc_Match_Next_Character_In_Virtual_Menu(
+|                           MENU *menu,
+|                           int  ch,
+|                           int  *current)
+|
+|   Description   :  Search for the next item of a virtual menu matching the
+|                    pattern. Only a page of the items is connected, but
+|                    the callback supplies the names of all items, so the
+|                    whole menu is searched.  The current parameter holds
+|                    the index of an item rather than a pointer.
+|
+|   Return Values :  E_OK        - an item matching the pattern was found
+|                    E_NO_MATCH  - nothing found
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+_nc_Match_Next_Character_In_Virtual_Menu
+(MENU * menu, int ch, int *current)
+{
+  T((T_CALLED("_nc_Match_Next_Character_In_Virtual_Menu(%p,%d,%p)"),
+     (void *)menu, ch, (void *)current));
 
-  if (found)
-    {
-      if (!((idx == (*item)->index) && passed))
-	{
-	  *item = menu->items[idx];
-	  RETURN(E_OK);
-	}
-      /* This point is reached, if we fully cycled through the item list
-         and the only match we found is the starting item. With a NEXT_PATTERN
-         or PREV_PATTERN scan this means, that there was no additional match.
-         If we searched with an expanded new pattern, we should never reach
-         this point, because if the expanded pattern matches also the actual
-         item we will find it in the first attempt (passed==FALSE) and we
-         will never cycle through the whole item array.
-       */
-      assert(ch == 0 || ch == BS);
-    }
-  else
-    {
-      if (ch && ch != BS && menu->pindex > 0)
-	{
-	  /* if we had no match with a new pattern, we have to restore it */
-	  Remove_Character_From_Pattern(menu);
-	}
-    }
-  RETURN(E_NO_MATCH);
+  assert(menu && menu->virt && current);
+  RETURN(Match_Next_Character(menu, ch, current));
 }
 
 /*---------------------------------------------------------------------------
@@ -236,6 +208,10 @@ menu_driver(MENU * menu, int c)
   my_top_row = menu->toprow;
   assert(item);
 
+  /* a virtual menu computes its own navigation */
+  if (menu->virt && _nc_Virtual_Driver(menu, c, &result))
+    RETURN(result);
+
   if ((c > KEY_MAX) && (c <= MAX_MENU_COMMAND))
     {
       if (!((c == REQ_BACK_PATTERN)
@@ -370,7 +346,7 @@ menu_driver(MENU * menu, int c)
 		{
 		  menu->curitem->value = !menu->curitem->value;
 		  Move_And_Post_Item(menu, menu->curitem);
-		  _nc_Show_Menu(menu);
+		  _nc_Update_Menu(menu, menu->toprow, menu->curitem);
 		}
 	      else
 		result = E_NOT_SELECTABLE;
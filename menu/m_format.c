@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2010,2012 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2012,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -70,7 +70,7 @@ set_menu_format(MENU * menu, int rows, int cols)
       if (menu->status & _POSTED)
 	RETURN(E_POSTED);
 
-      if (!(menu->items))
+      if (!(menu->items) && !(menu->virt))
 	RETURN(E_NOT_CONNECTED);
 
       if (rows == 0)
@@ -81,6 +81,9 @@ set_menu_format(MENU * menu, int rows, int cols)
       if (menu->pattern)
 	Reset_Pattern(menu);
 
+      if (menu->virt)
+	RETURN(_nc_Virtual_Format(menu, rows, cols));
+
       menu->frows = (short)rows;
       menu->fcols = (short)cols;
 
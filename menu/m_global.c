@@ -76,8 +76,9 @@ NCURSES_EXPORT_VAR(MENU) _nc_Default_Menu = {
   (Menu_Hook)0,			  /* Item term */
   (void *)0,			  /* userptr */
   mark,				  /* mark */
-  ALL_MENU_OPTS,                  /* options */
+  DEFAULT_MENU_OPTS,              /* options */
   0			          /* status */
+  NCURSES_MENU_EXTENSION
 };
 
 NCURSES_EXPORT_VAR(ITEM) _nc_Default_Item = {
@@ -154,6 +155,7 @@ ResetConnectionInfo(MENU * menu, ITEM ** items)
   if (menu->pattern)
     free(menu->pattern);
   menu->pattern = (char *)0;
+  _nc_Free_Match(menu);
   menu->pindex = 0;
   menu->items = (ITEM **) 0;
   menu->nitems = 0;
@@ -296,7 +298,7 @@ calculate_actual_width(MENU * menu, bool name)
 
   assert(menu && menu->items);
 
-  if (menu->items != 0)
+  if (menu->items != 0 && menu->virt == 0)
     {
       for (items = menu->items; *items; items++)
 	{
@@ -496,14 +498,30 @@ _nc_Link_Items(MENU * menu)
 
 /*---------------------------------------------------------------------------
 |   Facility      :  libnmenu
-|   Function      :  void _nc_Show_Menu(const MENU* menu)
+|   Function      :  static void Show_Lines(const MENU *menu, WINDOW *win,
+|                                          int first, int last, int maxx)
+|
+|   Description   :  Copy the given lines of the visible part of the menu
+|                    to its window.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Show_Lines(const MENU * menu, WINDOW *win, int first, int last, int maxx)
+{
+  copywin(menu->sub, win, first, 0, first, 0, last, maxx - 1, 0);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Show_Menu(MENU* menu)
 |
 |   Description   :  Update the window that is associated with the menu
 |
 |   Return Values :  -
 +--------------------------------------------------------------------------*/
 NCURSES_EXPORT(void)
-_nc_Show_Menu(const MENU * menu)
+_nc_Show_Menu(MENU * menu)
 {
   WINDOW *win;
   int maxy, maxx;
@@ -524,9 +542,97 @@ _nc_Show_Menu(const MENU * menu)
       if (menu->width < maxx)
 	maxx = menu->width;
 
-      copywin(menu->sub, win, 0, 0, 0, 0, maxy - 1, maxx - 1, 0);
+      Show_Lines(menu, win, 0, maxy - 1, maxx);
       pos_menu_cursor(menu);
+      SetStatus(menu, _SHOWN);
+    }
+  else
+    {
+      /* a hook changed the menu, but the window is not updated */
+      ClrStatus(menu, _SHOWN);
+    }
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Update_Menu(MENU* menu,
+|                                         int toprow,
+|                                         const ITEM *item)
+|
+|   Description   :  Update the window of the menu, which shows it with
+|                    the given top row, after the given item and the
+|                    current item were redrawn. Rather than copying all
+|                    of the visible part of the menu, the window is
+|                    scrolled to the new top row and only the lines which
+|                    scrolled into view, and those of the two items, are
+|                    copied.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Update_Menu(MENU * menu, int toprow, const ITEM * item)
+{
+  WINDOW *win;
+  int maxy, maxx;
+  int shift;
+  int y;
+
+  assert(menu && item);
+  if (!(menu->status & _SHOWN)
+      || !(menu->status & _POSTED)
+      || (menu->status & _IN_DRIVER))
+    {
+      _nc_Show_Menu(menu);
+      return;
     }
+
+  win = Get_Menu_Window(menu);
+
+  maxy = getmaxy(win);
+  maxx = getmaxx(win);
+
+  if (menu->height < maxy)
+    maxy = menu->height;
+  if (menu->width < maxx)
+    maxx = menu->width;
+
+  shift = menu->spc_rows * (menu->toprow - toprow);
+  if (shift != 0)
+    {
+      bool save_scroll = is_scrollok(win);
+      int save_top, save_bottom;
+
+      /* scrolling moves whole lines, so the menu must fill the window's
+         width.  Otherwise, or if nothing stays in view, copy everything */
+      if (maxx < getmaxx(win)
+	  || abs(shift) >= maxy
+	  || wgetscrreg(win, &save_top, &save_bottom) == ERR
+	  || wsetscrreg(win, 0, maxy - 1) == ERR)
+	{
+	  _nc_Show_Menu(menu);
+	  return;
+	}
+      mvderwin(menu->sub, menu->spc_rows * menu->toprow, 0);
+      scrollok(win, TRUE);
+      wscrl(win, shift);
+      scrollok(win, save_scroll);
+      wsetscrreg(win, save_top, save_bottom);
+      if (shift > 0)
+	Show_Lines(menu, win, maxy - shift, maxy - 1, maxx);
+      else
+	Show_Lines(menu, win, 0, -shift - 1, maxx);
+    }
+
+  y = menu->spc_rows * (item->y - menu->toprow);
+  if (y >= 0 && y < maxy)
+    Show_Lines(menu, win, y, y, maxx);
+  if (menu->curitem != item)
+    {
+      y = menu->spc_rows * (menu->curitem->y - menu->toprow);
+      if (y >= 0 && y < maxy)
+	Show_Lines(menu, win, y, y, maxx);
+    }
+  pos_menu_cursor(menu);
 }
 
 /*---------------------------------------------------------------------------
@@ -549,6 +655,7 @@ _nc_New_TopRow_and_CurrentItem(
 				ITEM * new_current_item)
 {
   ITEM *cur_item;
+  int cur_toprow;
   bool mterm_called = FALSE;
   bool iterm_called = FALSE;
 
@@ -567,6 +674,7 @@ _nc_New_TopRow_and_CurrentItem(
 	}
 
       cur_item = menu->curitem;
+      cur_toprow = menu->toprow;
       assert(cur_item);
       menu->toprow = (short)(((menu->rows - menu->frows) >= 0)
 			     ? min(menu->rows - menu->frows, new_toprow)
@@ -585,7 +693,7 @@ _nc_New_TopRow_and_CurrentItem(
 	}
       if (mterm_called || iterm_called)
 	{
-	  _nc_Show_Menu(menu);
+	  _nc_Update_Menu(menu, cur_toprow, cur_item);
 	}
       else
 	pos_menu_cursor(menu);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2004,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -99,7 +99,8 @@ current_item(const MENU * menu)
 |   Facility      :  libnmenu  
 |   Function      :  int item_index(const ITEM *)
 |   
-|   Description   :  Return the logical index of this item.
+|   Description   :  Return the logical index of this item.  In a virtual
+|                    menu this accounts for the items before the page.
 |
 |   Return Values :  The index or ERR if this is an invalid item pointer
 +--------------------------------------------------------------------------*/
@@ -107,7 +108,9 @@ NCURSES_EXPORT(int)
 item_index(const ITEM * item)
 {
   T((T_CALLED("item_index(%p)"), (const void *)item));
-  returnCode((item && item->imenu) ? item->index : ERR);
+  returnCode((item && item->imenu)
+	     ? item->index + Virtual_Index(item->imenu)
+	     : ERR);
 }
 
 /* m_item_cur.c ends here */
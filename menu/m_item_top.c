@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2004,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -63,6 +63,20 @@ set_top_row(MENU * menu, int row)
       if (menu->items == (ITEM **) 0)
 	RETURN(E_NOT_CONNECTED);
 
+      if (menu->virt)
+	{
+	  /* the page always starts at its top row */
+	  if ((row < 0) || (row > (menu->virt->rows - menu->arows)))
+	    RETURN(E_BAD_ARGUMENT);
+	  if (row != menu->virt->base)
+	    {
+	      assert(menu->pattern);
+	      Reset_Pattern(menu);
+	      _nc_Virtual_Move(menu, row, row * menu->cols);
+	    }
+	  RETURN(E_OK);
+	}
+
       if ((row < 0) || (row > (menu->rows - menu->arows)))
 	RETURN(E_BAD_ARGUMENT);
     }
@@ -98,7 +112,7 @@ top_row(const MENU * menu)
   if (menu && menu->items && *(menu->items))
     {
       assert((menu->toprow >= 0) && (menu->toprow < menu->rows));
-      returnCode(menu->toprow);
+      returnCode(menu->toprow + Virtual_Row(menu));
     }
   else
     returnCode(ERR);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2004,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -74,7 +74,7 @@ set_item_value(ITEM * item, bool value)
 	      if (menu->status & _POSTED)
 		{
 		  Move_And_Post_Item(menu, item);
-		  _nc_Show_Menu(menu);
+		  _nc_Update_Menu(menu, menu->toprow, item);
 		}
 	    }
 	}
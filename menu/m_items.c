@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2005,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -51,6 +51,7 @@ MODULE_ID("$Id: m_items.c,v 1.17 2010/01/23 21:20:10 tom Exp $")
 |                                     to another menu.
 |                    E_BAD_ARGUMENT - An incorrect menu or item array was
 |                                     passed to the function
+|                    E_REQUEST_DENIED - the menu is a virtual menu
 +--------------------------------------------------------------------------*/
 NCURSES_EXPORT(int)
 set_menu_items(MENU * menu, ITEM ** items)
@@ -63,6 +64,9 @@ set_menu_items(MENU * menu, ITEM ** items)
   if (menu->status & _POSTED)
     RETURN(E_POSTED);
 
+  if (menu->virt)
+    RETURN(E_REQUEST_DENIED);
+
   if (menu->items)
     _nc_Disconnect_Items(menu);
 
@@ -96,7 +100,8 @@ menu_items(const MENU * menu)
 |   Function      :  int item_count(const MENU *menu)
 |   
 |   Description   :  Get the number of items connected to the menu. If the
-|                    menu pointer is NULL we return -1.         
+|                    menu pointer is NULL we return -1.  For a virtual
+|                    menu, this is the number of items in the menu.
 |
 |   Return Values :  Number of items or -1 to indicate error.
 +--------------------------------------------------------------------------*/
@@ -104,7 +109,7 @@ NCURSES_EXPORT(int)
 item_count(const MENU * menu)
 {
   T((T_CALLED("item_count(%p)"), (const void *)menu));
-  returnCode(menu ? menu->nitems : -1);
+  returnCode(menu ? Item_Count(menu) : -1);
 }
 
 /* m_items.c ends here */
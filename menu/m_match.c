@@ -0,0 +1,546 @@
+/****************************************************************************
+ * Copyright (c) 2020 Free Software Foundation, Inc.                        *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/***************************************************************************
+* Module m_match                                                           *
+* Index of the item names for pattern matching                             *
+***************************************************************************/
+
+#include "menu.priv.h"
+
+MODULE_ID("$Id: m_match.c,v 1.1 2020/01/25 00:00:00 tom Exp $")
+
+/* The ways a pattern may match a name */
+#define MATCH_PREFIX	0
+#define MATCH_SUBSTRING	1
+#define MATCH_FUZZY	2
+
+#define Match_Mode(menu) \
+  (((menu)->opt & O_FUZZY) \
+   ? MATCH_FUZZY \
+   : (((menu)->opt & O_SUBSTRING) \
+      ? MATCH_SUBSTRING \
+      : MATCH_PREFIX))
+
+#define Fold(folded,c) \
+  (char) ((folded) ? toupper(UChar(c)) : UChar(c))
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static const char *Item_Name(const MENU *menu, int idx)
+|
+|   Description   :  Return the name of the item with the given index. For
+|                    a virtual menu the item need not be connected.
+|
+|   Return Values :  The name
++--------------------------------------------------------------------------*/
+static const char *
+Item_Name(const MENU * menu, int idx)
+{
+  const char *result;
+
+  if (menu->virt)
+    {
+      if ((result = menu->virt->name(menu, idx)) == 0)
+	result = "";
+    }
+  else
+    result = menu->items[idx]->name.str;
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Compare_Names(const void *a, const void *b)
+|
+|   Description   :  qsort callback ordering the names, and items with the
+|                    same name by their index.
+|
+|   Return Values :  <0, 0 or >0 as for strcmp
++--------------------------------------------------------------------------*/
+static int
+Compare_Names(const void *a, const void *b)
+{
+  const MATCH_NAME *p = (const MATCH_NAME *) a;
+  const MATCH_NAME *q = (const MATCH_NAME *) b;
+  int result = strcmp(p->name, q->name);
+
+  if (result == 0)
+    result = p->item - q->item;
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Free_Index(MATCH *match)
+|
+|   Description   :  Free an index and its storage.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Free_Index(MATCH * match)
+{
+  if (match->pool)
+    free(match->pool);
+  if (match->start)
+    free(match->start);
+  if (match->sorted)
+    free(match->sorted);
+  if (match->key)
+    free(match->key);
+  if (match->prefix)
+    free(match->prefix);
+  if (match->range)
+    free(match->range);
+  if (match->pattern)
+    free(match->pattern);
+  if (match->found)
+    free(match->found);
+  free(match);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static MATCH *Build_Index(MENU *menu, bool folded)
+|
+|   Description   :  Copy the names of all items of the menu, folded to
+|                    uppercase if requested, and sort them.
+|
+|   Return Values :  The index, or NULL if there is not enough memory
++--------------------------------------------------------------------------*/
+static MATCH *
+Build_Index(MENU * menu, bool folded)
+{
+  MATCH *match;
+  int count = Item_Count(menu);
+  int size = 0;
+  int used = 0;
+  int n;
+
+  if ((match = typeCalloc(MATCH, 1)) == 0)
+    return (MATCH *) 0;
+
+  match->count = count;
+  match->folded = folded;
+  if (count > 0
+      && ((match->start = typeMalloc(int, (unsigned)count)) == 0
+	  || (match->sorted = typeMalloc(MATCH_NAME, (unsigned)count)) == 0
+	  || (match->found = typeMalloc(int, (unsigned)count)) == 0))
+    {
+      Free_Index(match);
+      return (MATCH *) 0;
+    }
+
+  for (n = 0; n < count; ++n)
+    {
+      const char *name = Item_Name(menu, n);
+      size_t len = strlen(name);
+
+      if (len > (size_t) (INT_MAX - 1 - used))
+	{
+	  Free_Index(match);
+	  return (MATCH *) 0;
+	}
+      if (used + (int)len + 1 > size)
+	{
+	  size = used + (int)len + 1;
+	  if (size <= INT_MAX / 2)
+	    size *= 2;
+	  if ((match->pool = typeRealloc(char, (unsigned)size, match->pool)) == 0)
+	    {
+	      Free_Index(match);
+	      return (MATCH *) 0;
+	    }
+	}
+      match->start[n] = used;
+      while (*name != '\0')
+	{
+	  match->pool[used++] = Fold(folded, *name);
+	  ++name;
+	}
+      match->pool[used++] = '\0';
+      if ((int)len > match->longest)
+	match->longest = (int)len;
+    }
+
+  /* the pool may have moved while it grew, so set the names afterwards */
+  for (n = 0; n < count; ++n)
+    {
+      match->sorted[n].name = match->pool + match->start[n];
+      match->sorted[n].item = n;
+    }
+  if (count > 1)
+    qsort(match->sorted, (size_t) count, sizeof(MATCH_NAME), Compare_Names);
+
+  n = match->longest + 1;
+  if ((match->key = typeMalloc(char, (unsigned)n)) == 0
+      || (match->prefix = typeMalloc(char, (unsigned)n)) == 0
+      || (match->pattern = typeMalloc(char, (unsigned)n)) == 0
+      || (match->range = typeMalloc(int, (unsigned)(2 * n))) == 0)
+    {
+      Free_Index(match);
+      return (MATCH *) 0;
+    }
+  match->range[0] = 0;
+  match->range[1] = count;
+  match->levels = 0;
+  match->length = -1;
+  return match;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static MATCH *Get_Index(MENU *menu)
+|
+|   Description   :  Return the index of the menu, building it if needed.
+|                    The index is rebuilt when O_IGNORECASE has changed.
+|
+|   Return Values :  The index, or NULL if there is not enough memory
++--------------------------------------------------------------------------*/
+static MATCH *
+Get_Index(MENU * menu)
+{
+  bool folded = (bool)((menu->opt & O_IGNORECASE) != 0);
+
+  if (menu->match != 0 && menu->match->folded != folded)
+    _nc_Free_Match(menu);
+  if (menu->match == 0)
+    menu->match = Build_Index(menu, folded);
+  return menu->match;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Bound(const MATCH_NAME *sorted,
+|                                     int lo, int hi, int k, int ch)
+|
+|   Description   :  The names in sorted[lo..hi-1] share their first k
+|                    characters, so they are ordered by their k'th one.
+|                    Find the first of them whose k'th character is not
+|                    below ch.
+|
+|   Return Values :  The position, or hi if there is none
++--------------------------------------------------------------------------*/
+static int
+Bound(const MATCH_NAME * sorted, int lo, int hi, int k, int ch)
+{
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (UChar(sorted[mid].name[k]) < ch)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Prefix_Range(MATCH *match, int length,
+|                                             int *first, int *last)
+|
+|   Description   :  Find the range of sorted names which begin with the
+|                    key. The ranges for the prefixes which the key shares
+|                    with the last one are reused, and each further
+|                    character narrows the range of the one before.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Prefix_Range(MATCH * match, int length, int *first, int *last)
+{
+  const char *key = match->key;
+  int k = 0;
+
+  while (k < length && k < match->levels && match->prefix[k] == key[k])
+    ++k;
+
+  if (k < length)
+    {
+      for (; k < length; ++k)
+	{
+	  int lo = match->range[2 * k];
+	  int hi = match->range[2 * k + 1];
+	  int ch = UChar(key[k]);
+
+	  lo = Bound(match->sorted, lo, hi, k, ch);
+	  hi = Bound(match->sorted, lo, hi, k, ch + 1);
+	  match->range[2 * (k + 1)] = lo;
+	  match->range[2 * (k + 1) + 1] = hi;
+	  match->prefix[k] = key[k];
+	}
+      match->levels = length;
+    }
+  *first = match->range[2 * length];
+  *last = match->range[2 * length + 1];
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Scan_Range(const MATCH *match,
+|                                          int lo, int hi,
+|                                          int from, int step,
+|                                          bool inclusive)
+|
+|   Description   :  Find the item in sorted[lo..hi-1] which comes first
+|                    when cycling through the items from the given one in
+|                    the direction of step. The starting item itself is
+|                    only taken if inclusive is set.
+|
+|   Return Values :  The index of the item, or -1 if there is none
++--------------------------------------------------------------------------*/
+static int
+Scan_Range(const MATCH * match, int lo, int hi, int from, int step,
+	   bool inclusive)
+{
+  int count = match->count;
+  int best = -1;
+  int best_dist = count;
+  int n;
+
+  for (n = lo; n < hi; ++n)
+    {
+      int item = match->sorted[n].item;
+      int dist = (item - from) * step;
+
+      if (dist < 0)
+	dist += count;
+      else if (dist == 0 && !inclusive)
+	continue;
+      if (dist < best_dist)
+	{
+	  best_dist = dist;
+	  best = item;
+	  if (dist == 0)
+	    break;
+	}
+    }
+  return best;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static bool Is_Match(const char *name,
+|                                         const char *key,
+|                                         int mode)
+|
+|   Description   :  Check whether the key is a substring of the name, or
+|                    for MATCH_FUZZY whether its characters appear in the
+|                    name in the same order.
+|
+|   Return Values :  TRUE   - if the name matches
+|                    FALSE  - if it does not
++--------------------------------------------------------------------------*/
+static bool
+Is_Match(const char *name, const char *key, int mode)
+{
+  if (mode == MATCH_SUBSTRING)
+    return (bool)(strstr(name, key) != 0);
+
+  while (*key != '\0' && *name != '\0')
+    {
+      if (*name++ == *key)
+	++key;
+    }
+  return (bool)(*key == '\0');
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Update_Found(MATCH *match, int length,
+|                                             int mode)
+|
+|   Description   :  Make the found list hold the items matching the key.
+|                    If the key extends the pattern of the list, any item
+|                    matching the key is already in it, so only the list
+|                    is filtered rather than all items.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Update_Found(MATCH * match, int length, int mode)
+{
+  const char *key = match->key;
+  bool narrow = (bool)(match->mode == mode
+		       && match->length >= 0
+		       && match->length <= length
+		       && !strncmp(match->pattern, key, (size_t) match->length));
+  int count;
+  int nfound = 0;
+  int n;
+
+  if (narrow && match->length == length)
+    return;
+
+  count = narrow ? match->nfound : match->count;
+  for (n = 0; n < count; ++n)
+    {
+      int item = narrow ? match->found[n] : n;
+
+      if (Is_Match(match->pool + match->start[item], key, mode))
+	match->found[nfound++] = item;
+    }
+  memcpy(match->pattern, key, (size_t) (length + 1));
+  match->length = length;
+  match->mode = mode;
+  match->nfound = nfound;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Search_Found(const MATCH *match,
+|                                            int from, int step,
+|                                            bool inclusive)
+|
+|   Description   :  As Scan_Range(), but for the found list, which is in
+|                    the order of the items.
+|
+|   Return Values :  The index of the item, or -1 if there is none
++--------------------------------------------------------------------------*/
+static int
+Search_Found(const MATCH * match, int from, int step, bool inclusive)
+{
+  const int *found = match->found;
+  int nfound = match->nfound;
+  int lo = 0;
+  int hi = nfound;
+  int result;
+  bool here;
+
+  if (nfound == 0)
+    return -1;
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (found[mid] < from)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  here = (bool)(lo < nfound && found[lo] == from);
+
+  if (step > 0)
+    {
+      if (here && !inclusive)
+	++lo;
+      if (lo >= nfound)
+	lo = 0;
+    }
+  else
+    {
+      if (!(here && inclusive))
+	--lo;
+      if (lo < 0)
+	lo = nfound - 1;
+    }
+  result = found[lo];
+  if (result == from && !inclusive)
+    result = -1;
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  int _nc_Find_Match(MENU *menu, int from, int step,
+|                                       bool inclusive)
+|
+|   Description   :  Find the item matching the pattern of the menu which
+|                    comes first when cycling through the items from the
+|                    given one, forward if step is positive, else
+|                    backward. The starting item is a candidate only if
+|                    inclusive is set.
+|
+|                    Names match if they begin with the pattern, or with
+|                    O_SUBSTRING if they contain it, or with O_FUZZY if
+|                    they contain its characters in order.
+|
+|   Return Values :  The index of the item, or -1 if there is none
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+_nc_Find_Match(MENU * menu, int from, int step, bool inclusive)
+{
+  MATCH *match;
+  int length = menu->pindex;
+  int result = -1;
+
+  T((T_CALLED("_nc_Find_Match(%p,%d,%d,%d)"),
+     (void *)menu, from, step, inclusive));
+
+  if ((match = Get_Index(menu)) != 0
+      && match->count > 0
+      && length <= match->longest)
+    {
+      bool folded = match->folded;
+      int mode = Match_Mode(menu);
+      int n;
+
+      for (n = 0; n < length; ++n)
+	match->key[n] = Fold(folded, menu->pattern[n]);
+      match->key[length] = '\0';
+
+      if (mode == MATCH_PREFIX)
+	{
+	  int lo, hi;
+
+	  Prefix_Range(match, length, &lo, &hi);
+	  result = Scan_Range(match, lo, hi, from, step, inclusive);
+	}
+      else
+	{
+	  Update_Found(match, length, mode);
+	  result = Search_Found(match, from, step, inclusive);
+	}
+    }
+  returnCode(result);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Free_Match(MENU *menu)
+|
+|   Description   :  Discard the index of the menu, e.g., because its
+|                    items have changed. It is rebuilt when needed.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Free_Match(MENU * menu)
+{
+  if (menu->match)
+    {
+      Free_Index(menu->match);
+      menu->match = (MATCH *) 0;
+    }
+}
+
+/* m_match.c ends here */
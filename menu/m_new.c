@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -132,6 +132,10 @@ free_menu(MENU * menu)
   if (menu->items)
     _nc_Disconnect_Items(menu);
 
+  if (menu->virt)
+    _nc_Free_Virtual(menu);
+  _nc_Free_Match(menu);
+
   if ((menu->status & _MARK_ALLOCATED) && menu->mark)
     free(menu->mark);
 
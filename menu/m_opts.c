@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2004,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -67,6 +67,10 @@ set_menu_opts(MENU * menu, Menu_Options opts)
       if (menu->status & _POSTED)
 	RETURN(E_POSTED);
 
+      /* a virtual menu pages through whole rows of items */
+      if (menu->virt)
+	opts |= O_ROWMAJOR;
+
       if ((opts & O_ROWMAJOR) != (menu->opt & O_ROWMAJOR))
 	{
 	  /* we need this only if the layout really changed ... */
@@ -88,6 +92,8 @@ set_menu_opts(MENU * menu, Menu_Options opts)
 	  if (((item = menu->items) != (ITEM **) 0))
 	    for (; *item; item++)
 	      (*item)->value = FALSE;
+	  if (menu->virt)
+	    _nc_Virtual_Clear(menu);
 	}
 
       if (opts & O_SHOWDESC)	/* this also changes the geometry */
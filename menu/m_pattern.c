@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2006,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -77,6 +77,7 @@ set_menu_pattern(MENU * menu, const char *p)
 {
   ITEM *matchitem;
   int matchpos;
+  int matchidx;
 
   T((T_CALLED("set_menu_pattern(%p,%s)"), (void *)menu, _nc_visbuf(p)));
 
@@ -103,11 +104,15 @@ set_menu_pattern(MENU * menu, const char *p)
   matchpos = menu->toprow;
   matchitem = menu->curitem;
   assert(matchitem);
+  matchidx = Virtual_Index(menu) + matchitem->index;
 
   while (*p)
     {
       if (!isprint(UChar(*p)) ||
-	  (_nc_Match_Next_Character_In_Item_Name(menu, *p, &matchitem) != E_OK))
+	  ((menu->virt
+	    ? _nc_Match_Next_Character_In_Virtual_Menu(menu, *p, &matchidx)
+	    : _nc_Match_Next_Character_In_Item_Name(menu, *p, &matchitem))
+	   != E_OK))
 	{
 	  Reset_Pattern(menu);
 	  pos_menu_cursor(menu);
@@ -117,7 +122,10 @@ set_menu_pattern(MENU * menu, const char *p)
     }
 
   /* This is reached if there was a match. So we position to the new item */
-  Adjust_Current_Item(menu, matchpos, matchitem);
+  if (menu->virt)
+    _nc_Virtual_Adjust(menu, matchidx);
+  else
+    Adjust_Current_Item(menu, matchpos, matchitem);
   RETURN(E_OK);
 }
 
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2010,2012 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2012,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -307,6 +307,10 @@ post_menu(MENU * menu)
 
   SetStatus(menu, _POSTED);
 
+  /* the names of a virtual menu may have changed while it was unposted */
+  if (menu->virt)
+    _nc_Free_Match(menu);
+
   if (!(menu->opt & O_ONEVALUE))
     {
       ITEM **items;
@@ -315,6 +319,8 @@ post_menu(MENU * menu)
 	{
 	  (*items)->value = FALSE;
 	}
+      if (menu->virt)
+	_nc_Virtual_Clear(menu);
     }
 
   _nc_Draw_Menu(menu);
@@ -370,6 +376,7 @@ unpost_menu(MENU * menu)
   menu->win = (WINDOW *)0;
 
   ClrStatus(menu, _POSTED);
+  ClrStatus(menu, _SHOWN);
 
   RETURN(E_OK);
 }
@@ -0,0 +1,834 @@
+/****************************************************************************
+ * Copyright (c) 2020 Free Software Foundation, Inc.                        *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/***************************************************************************
+* Module m_virtual                                                         *
+* Menus whose items are supplied by callbacks                              *
+***************************************************************************/
+
+#include "menu.priv.h"
+
+MODULE_ID("$Id: m_virtual.c,v 1.1 2020/01/25 00:00:00 tom Exp $")
+
+#define minimum(a,b) ((a)<(b) ? (a): (b))
+
+/* Bits of the selection values */
+#define Value_Byte(n)	((n) / 8)
+#define Value_Bit(n)	UChar(1 << ((n) % 8))
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Text_Length(const char *value, int limit)
+|
+|   Description   :  Compute how many bytes of the text fit into the given
+|                    number of columns.
+|
+|   Return Values :  The number of bytes
++--------------------------------------------------------------------------*/
+static int
+Text_Length(const char *value, int limit)
+{
+  int length = (int)strlen(value);
+
+#if USE_WIDEC_SUPPORT
+  int result = 0;
+  int width = 0;
+
+#ifndef state_unused
+  mbstate_t state;
+#endif
+
+  reset_mbytes(state);
+  while (result < length)
+    {
+      wchar_t wch;
+      int used = check_mbytes(wch, value + result,
+			      (size_t) (length - result), state);
+      int test;
+
+      if (used <= 0)
+	{
+	  /* count an invalid byte as one column */
+	  reset_mbytes(state);
+	  used = 1;
+	  test = 1;
+	}
+      else if ((test = wcwidth(wch)) <= 0)
+	{
+	  test = 1;
+	}
+      if (width + test > limit)
+	break;
+      width += test;
+      result += used;
+    }
+  return result;
+#else
+  return minimum(length, limit);
+#endif
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Load_Text(
+|                           char **store,
+|                           TEXT *text,
+|                           const char *value,
+|                           int limit)
+|
+|   Description   :  Copy a text returned by a callback into the storage of
+|                    a page item, truncating it to the given width.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Load_Text(char **store, TEXT * text, const char *value, int limit)
+{
+  int length = 0;
+
+  if (value != 0)
+    length = Text_Length(value, limit);
+
+  FreeIfNeeded(*store);
+  if ((*store = typeMalloc(char, (size_t) length + 1)) != 0)
+    {
+      if (length != 0)
+	memcpy(*store, value, (size_t) length);
+      (*store)[length] = '\0';
+    }
+  else
+    length = 0;
+
+  text->str = *store;
+  text->length = (unsigned short)length;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static bool Get_Value(const VIRTUAL *virt, int n)
+|
+|   Description   :  Return the stored selection value of an item.
+|
+|   Return Values :  TRUE   - if item is selected
+|                    FALSE  - if item is not selected
++--------------------------------------------------------------------------*/
+static bool
+Get_Value(const VIRTUAL * virt, int n)
+{
+  return (bool)(virt->values != 0
+		&& (virt->values[Value_Byte(n)] & Value_Bit(n)) != 0);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Set_Value(VIRTUAL *virt, int n, bool value)
+|
+|   Description   :  Store the selection value of an item.  The bitmap is
+|                    allocated when the first item is selected.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Set_Value(VIRTUAL * virt, int n, bool value)
+{
+  if (value && virt->values == 0)
+    virt->values = typeCalloc(unsigned char,
+			      (size_t) Value_Byte(virt->count - 1) + 1);
+
+  if (virt->values != 0)
+    {
+      if (value)
+	virt->values[Value_Byte(n)] |= Value_Bit(n);
+      else
+	virt->values[Value_Byte(n)] &= UChar(~Value_Bit(n));
+    }
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Store_Values(MENU *menu)
+|
+|   Description   :  Save the selection values of the items in the page,
+|                    before the page is reused.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Store_Values(MENU * menu)
+{
+  int first = Virtual_Index(menu);
+  int n;
+
+  for (n = 0; n < menu->nitems; ++n)
+    Set_Value(menu->virt, first + n, menu->items[n]->value);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Fill_Page(MENU *menu, int base)
+|
+|   Description   :  Load the page with the items of the rows starting at
+|                    base, and link them together.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Fill_Page(MENU * menu, int base)
+{
+  VIRTUAL *virt = menu->virt;
+  int first = base * menu->cols;
+  int count = minimum(virt->count - first, menu->arows * menu->cols);
+  int n;
+
+  for (n = 0; n < count; ++n)
+    {
+      ITEM *item = &(virt->pool[n]);
+
+      *item = _nc_Default_Item;
+      item->imenu = menu;
+      item->index = (short)n;
+      Load_Text(&(virt->text[2 * n]), &(item->name),
+		virt->name(menu, first + n), menu->namelen);
+      if (virt->desc != 0)
+	Load_Text(&(virt->text[2 * n + 1]), &(item->description),
+		  virt->desc(menu, first + n), menu->desclen);
+      item->value = Get_Value(virt, first + n);
+      virt->page[n] = item;
+    }
+  virt->page[count] = (ITEM *) 0;
+  virt->base = base;
+
+  menu->items = virt->page;
+  menu->nitems = (short)count;
+  _nc_Link_Items(menu);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static void Free_Page(VIRTUAL *virt)
+|
+|   Description   :  Free the storage for the page items.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+static void
+Free_Page(VIRTUAL * virt)
+{
+  if (virt->text != 0)
+    {
+      int n;
+
+      for (n = 0; n < 2 * virt->size; ++n)
+	FreeIfNeeded(virt->text[n]);
+      FreeAndNull(virt->text);
+    }
+  FreeIfNeeded(virt->pool);
+  FreeIfNeeded(virt->page);
+  virt->pool = (ITEM *) 0;
+  virt->page = (ITEM **) 0;
+  virt->size = 0;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Page_For(
+|                           const MENU *menu,
+|                           int base,
+|                           int target)
+|
+|   Description   :  Adjust the proposed first row of the page so that the
+|                    target item is in the page.
+|
+|   Return Values :  The first row
++--------------------------------------------------------------------------*/
+static int
+Page_For(const MENU * menu, int base, int target)
+{
+  int row = target / menu->cols;
+
+  if (row < base)
+    base = row;
+  else if (row >= base + menu->arows)
+    base = row - menu->arows + 1;
+  return minimum(base, menu->virt->rows - menu->arows);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  static int Neighbor(const MENU *menu, int n, int c)
+|
+|   Description   :  Compute the neighbor of an item for a navigation
+|                    request, in the same way as _nc_Link_Items() does for
+|                    a row-major menu.
+|
+|   Return Values :  The index of the neighbor, or -1 if there is none
++--------------------------------------------------------------------------*/
+static int
+Neighbor(const MENU * menu, int n, int c)
+{
+  int count = menu->virt->count;
+  int rows = menu->virt->rows;
+  int cols = menu->cols;
+  int row = n / cols;
+  int col = n % cols;
+  bool cycle = (menu->opt & O_NONCYCLIC) ? FALSE : TRUE;
+  int result = -1;
+
+  switch (c)
+    {
+    case REQ_LEFT_ITEM:
+      if (col)
+	result = n - 1;
+      else if (cycle)
+	result = minimum(row * cols + (cols - 1), count - 1);
+      break;
+    case REQ_RIGHT_ITEM:
+      if ((col < (cols - 1)) && ((n + 1) < count))
+	result = n + 1;
+      else if (cycle)
+	result = row * cols;
+      break;
+    case REQ_UP_ITEM:
+      if (row)
+	result = n - cols;
+      else if (cycle)
+	result = minimum((rows - 1) * cols + col, count - 1);
+      break;
+    case REQ_DOWN_ITEM:
+      if ((n + cols) < count)
+	result = n + cols;
+      else if (cycle)
+	result = ((row + 1) < rows) ? count - 1 : col;
+      break;
+    case REQ_NEXT_ITEM:
+      if ((n + 1) < count)
+	result = n + 1;
+      else if (cycle)
+	result = 0;
+      break;
+    case REQ_PREV_ITEM:
+      if (n > 0)
+	result = n - 1;
+      else if (cycle)
+	result = count - 1;
+      break;
+    }
+  return result;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  int _nc_Virtual_Format(MENU *menu, int rows, int cols)
+|
+|   Description   :  Does the work of set_menu_format() for a virtual menu.
+|                    The page is sized to show at most the given rows, and
+|                    is reloaded from the first item.
+|
+|   Return Values :  E_OK                   - success
+|                    E_BAD_ARGUMENT         - the page would be too large
+|                    E_SYSTEM_ERROR         - malloc failure
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+_nc_Virtual_Format(MENU * menu, int rows, int cols)
+{
+  VIRTUAL *virt = menu->virt;
+  int total_rows = (virt->count - 1) / cols + 1;
+  int total_cols = minimum(virt->count, cols);
+  int page_rows = minimum(total_rows, rows);
+  int size;
+
+  T((T_CALLED("_nc_Virtual_Format(%p,%d,%d)"), (void *)menu, rows, cols));
+
+  if (page_rows > (SHRT_MAX - 1) / total_cols)
+    RETURN(E_BAD_ARGUMENT);
+  size = page_rows * total_cols;
+
+  Store_Values(menu);
+
+  if (size > virt->size)
+    {
+      ITEM *pool = typeCalloc(ITEM, (size_t) size);
+      ITEM **page = typeCalloc(ITEM *, (size_t) size + 1);
+      char **text = typeCalloc(char *, 2 * (size_t) size);
+
+      if (pool == 0 || page == 0 || text == 0)
+	{
+	  FreeIfNeeded(pool);
+	  FreeIfNeeded(page);
+	  FreeIfNeeded(text);
+	  RETURN(E_SYSTEM_ERROR);
+	}
+      Free_Page(virt);
+      virt->pool = pool;
+      virt->page = page;
+      virt->text = text;
+      virt->size = size;
+    }
+
+  menu->frows = (short)rows;
+  menu->fcols = (short)cols;
+  virt->rows = total_rows;
+
+  menu->rows = (short)page_rows;
+  menu->cols = (short)total_cols;
+  menu->arows = (short)page_rows;
+  menu->toprow = 0;
+  Fill_Page(menu, 0);
+  menu->curitem = *(menu->items);
+  _nc_Calculate_Item_Length_and_Width(menu);
+
+  RETURN(E_OK);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Virtual_Move(
+|                            MENU *menu,
+|                            int base,
+|                            int target)
+|
+|   Description   :  Reload the page to start with the row base if needed,
+|                    and make the target item the current item.  This is
+|                    _nc_New_TopRow_and_CurrentItem() for virtual menus,
+|                    and calls the hooks in the same way.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Virtual_Move(MENU * menu, int base, int target)
+{
+  ITEM *cur_item;
+  bool new_page;
+  bool new_item;
+
+  assert(menu && menu->virt && menu->curitem);
+
+  cur_item = menu->curitem;
+  new_page = (bool)(base != menu->virt->base);
+  new_item = (bool)(target != Virtual_Index(menu) + cur_item->index);
+
+  if (menu->status & _POSTED)
+    {
+      if (new_item)
+	{
+	  Call_Hook(menu, itemterm);
+	}
+      if (new_page)
+	{
+	  Call_Hook(menu, menuterm);
+	  Store_Values(menu);
+	  Fill_Page(menu, base);
+	}
+      menu->curitem = menu->items[target - Virtual_Index(menu)];
+
+      if (new_page)
+	{
+	  _nc_Draw_Menu(menu);
+	  Call_Hook(menu, menuinit);
+	}
+      else if (new_item)
+	{
+	  Move_To_Current_Item(menu, cur_item);
+	}
+      if (new_item)
+	{
+	  Call_Hook(menu, iteminit);
+	}
+      if (new_page)
+	_nc_Show_Menu(menu);
+      else if (new_item)
+	_nc_Update_Menu(menu, menu->toprow, cur_item);
+      else
+	pos_menu_cursor(menu);
+    }
+  else
+    {
+      if (new_page)
+	{
+	  Store_Values(menu);
+	  Fill_Page(menu, base);
+	}
+      menu->curitem = menu->items[target - Virtual_Index(menu)];
+    }
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Virtual_Adjust(MENU *menu, int n)
+|
+|   Description   :  Make the n'th item the current item.  As with
+|                    Adjust_Current_Item(), an item outside the page
+|                    becomes the top row if possible.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Virtual_Adjust(MENU * menu, int n)
+{
+  int row = n / menu->cols;
+  int base = menu->virt->base;
+
+  if (row < base || row >= base + menu->arows)
+    base = minimum(row, menu->virt->rows - menu->arows);
+  _nc_Virtual_Move(menu, base, n);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  bool _nc_Virtual_Driver(MENU *menu, int c, int *result)
+|
+|   Description   :  Handle the requests of menu_driver() which move beyond
+|                    the page of a virtual menu.  The others, e.g., toggling
+|                    an item or mouse events, work on the page as for other
+|                    menus.
+|
+|   Return Values :  TRUE       - the request was handled, *result is set
+|                    FALSE      - the request is left to menu_driver()
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(bool)
+_nc_Virtual_Driver(MENU * menu, int c, int *result)
+{
+  VIRTUAL *virt = menu->virt;
+  int base = virt->base;
+  int current = Virtual_Index(menu) + menu->curitem->index;
+  int target = current;
+  int next, rdiff;
+
+  *result = E_OK;
+
+  if ((c > KEY_MAX) && (c <= MAX_MENU_COMMAND))
+    {
+      if ((c == REQ_TOGGLE_ITEM)
+	  || (c == REQ_CLEAR_PATTERN)
+	  || (c == REQ_BACK_PATTERN))
+	return FALSE;
+
+      if (!((c == REQ_NEXT_MATCH) || (c == REQ_PREV_MATCH)))
+	{
+	  assert(menu->pattern);
+	  Reset_Pattern(menu);
+	}
+
+      switch (c)
+	{
+	case REQ_LEFT_ITEM:
+	case REQ_RIGHT_ITEM:
+	case REQ_UP_ITEM:
+	case REQ_DOWN_ITEM:
+	case REQ_NEXT_ITEM:
+	case REQ_PREV_ITEM:
+	  target = Neighbor(menu, current, c);
+	  break;
+
+	case REQ_SCR_ULINE:
+	  if (base == 0)
+	    target = -1;
+	  else
+	    {
+	      --base;
+	      target = current - menu->cols;
+	    }
+	  break;
+
+	case REQ_SCR_DLINE:
+	  if (base + menu->arows >= virt->rows)
+	    target = -1;
+	  else if ((target = Neighbor(menu, current, REQ_DOWN_ITEM)) >= 0)
+	    ++base;
+	  break;
+
+	case REQ_SCR_DPAGE:
+	  rdiff = minimum(virt->rows - (menu->arows + base), menu->arows);
+	  if (rdiff <= 0)
+	    target = -1;
+	  else
+	    {
+	      base += rdiff;
+	      while (rdiff-- > 0
+		     && (next = Neighbor(menu, target, REQ_DOWN_ITEM)) >= 0)
+		target = next;
+	    }
+	  break;
+
+	case REQ_SCR_UPAGE:
+	  rdiff = minimum(base, menu->arows);
+	  if (rdiff <= 0)
+	    target = -1;
+	  else
+	    {
+	      base -= rdiff;
+	      while (rdiff-- > 0
+		     && (next = Neighbor(menu, target, REQ_UP_ITEM)) >= 0)
+		target = next;
+	    }
+	  break;
+
+	case REQ_FIRST_ITEM:
+	  target = 0;
+	  break;
+
+	case REQ_LAST_ITEM:
+	  target = virt->count - 1;
+	  break;
+
+	case REQ_NEXT_MATCH:
+	  assert(menu->pattern);
+	  if (menu->pattern[0])
+	    *result = _nc_Match_Next_Character_In_Virtual_Menu(menu, 0,
+							       &target);
+	  else
+	    target = Neighbor(menu, current, REQ_NEXT_ITEM);
+	  break;
+
+	case REQ_PREV_MATCH:
+	  assert(menu->pattern);
+	  if (menu->pattern[0])
+	    *result = _nc_Match_Next_Character_In_Virtual_Menu(menu, BS,
+							       &target);
+	  else
+	    target = Neighbor(menu, current, REQ_PREV_ITEM);
+	  break;
+
+	default:
+	  *result = E_UNKNOWN_COMMAND;
+	  break;
+	}
+    }
+  else if (!(c & ~((int)MAX_REGULAR_CHARACTER)) && isprint(UChar(c)))
+    {
+      *result = _nc_Match_Next_Character_In_Virtual_Menu(menu, c, &target);
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  if (*result == E_OK)
+    {
+      if (target < 0)
+	*result = E_REQUEST_DENIED;
+      else
+	_nc_Virtual_Move(menu, Page_For(menu, base, target), target);
+    }
+  return TRUE;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Virtual_Clear(MENU *menu)
+|
+|   Description   :  Forget the selection values of the items which are not
+|                    in the page.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Virtual_Clear(MENU * menu)
+{
+  assert(menu && menu->virt);
+  FreeAndNull(menu->virt->values);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  void _nc_Free_Virtual(MENU *menu)
+|
+|   Description   :  Free the data of a virtual menu, after its page has
+|                    been disconnected.
+|
+|   Return Values :  -
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(void)
+_nc_Free_Virtual(MENU * menu)
+{
+  assert(menu && menu->virt);
+  Free_Page(menu->virt);
+  FreeIfNeeded(menu->virt->values);
+  free(menu->virt);
+  menu->virt = (VIRTUAL *) 0;
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  MENU* _nc_new_virtual_menu(
+|                           SCREEN *sp,
+|                           int count,
+|                           int namelen,
+|                           int desclen,
+|                           Menu_Text name,
+|                           Menu_Text desc)
+|
+|   Description   :  Creates a new menu with count items, whose names and
+|                    descriptions are returned by the callbacks.  The
+|                    lengths give the widths reserved for them.  Only the
+|                    items of one page are created.
+|
+|   Return Values :  NULL on error
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(MENU *)
+NCURSES_SP_NAME(new_virtual_menu) (NCURSES_SP_DCLx
+				   int count,
+				   int namelen,
+				   int desclen,
+				   Menu_Text name,
+				   Menu_Text desc)
+{
+  int err = E_BAD_ARGUMENT;
+  MENU *menu = (MENU *) 0;
+
+  TR_FUNC_BFR(2);
+
+  T((T_CALLED("new_virtual_menu(%p,%d,%d,%d,%s,%s)"),
+     (void *)SP_PARM, count, namelen, desclen,
+     TR_FUNC_ARG(0, name), TR_FUNC_ARG(1, desc)));
+
+  if (count > 0
+      && namelen > 0 && namelen <= SHRT_MAX
+      && desclen >= 0 && desclen <= SHRT_MAX
+      && name != 0)
+    {
+      err = E_SYSTEM_ERROR;
+      menu = NCURSES_SP_NAME(new_menu) (NCURSES_SP_ARGx(ITEM **) 0);
+      if (menu != 0)
+	{
+	  if ((menu->virt = typeCalloc(VIRTUAL, 1)) != 0
+	      && (menu->pattern = typeMalloc(char, (unsigned)(1 + namelen))))
+	    {
+	      menu->virt->count = count;
+	      menu->virt->name = name;
+	      menu->virt->desc = desc;
+	      menu->namelen = (short)namelen;
+	      menu->desclen = (short)((desc != 0) ? desclen : 0);
+	      menu->opt |= O_ROWMAJOR;
+	      Reset_Pattern(menu);
+	      err = _nc_Virtual_Format(menu, menu->frows, menu->fcols);
+	    }
+	  if (err != E_OK)
+	    {
+	      FreeIfNeeded(menu->pattern);
+	      if (menu->virt)
+		_nc_Free_Virtual(menu);
+	      free(menu);
+	      menu = (MENU *) 0;
+	    }
+	}
+    }
+
+  if (!menu)
+    SET_ERROR(err);
+
+  returnMenu(menu);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  MENU *new_virtual_menu(
+|                           int count,
+|                           int namelen,
+|                           int desclen,
+|                           Menu_Text name,
+|                           Menu_Text desc)
+|
+|   Description   :  Creates a new menu with count items, whose names and
+|                    descriptions are returned by the callbacks.
+|
+|   Return Values :  NULL on error
++--------------------------------------------------------------------------*/
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(MENU *)
+new_virtual_menu(int count,
+		 int namelen,
+		 int desclen,
+		 Menu_Text name,
+		 Menu_Text desc)
+{
+  return NCURSES_SP_NAME(new_virtual_menu) (CURRENT_SCREEN,
+					    count, namelen, desclen,
+					    name, desc);
+}
+#endif
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  int set_virtual_item(MENU *menu, int n)
+|
+|   Description   :  Make the n'th item of a virtual menu the current item,
+|                    loading the page which contains it.
+|
+|   Return Values :  E_OK                - success
+|                    E_BAD_ARGUMENT      - not a virtual menu or invalid n
+|                    E_BAD_STATE         - called from a hook routine
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(int)
+set_virtual_item(MENU * menu, int n)
+{
+  T((T_CALLED("set_virtual_item(%p,%d)"), (void *)menu, n));
+
+  if (!menu || !menu->virt || n < 0 || n >= menu->virt->count)
+    RETURN(E_BAD_ARGUMENT);
+
+  if (menu->status & _IN_DRIVER)
+    RETURN(E_BAD_STATE);
+
+  assert(menu->pattern);
+  Reset_Pattern(menu);
+  _nc_Virtual_Adjust(menu, n);
+
+  RETURN(E_OK);
+}
+
+/*---------------------------------------------------------------------------
+|   Facility      :  libnmenu
+|   Function      :  bool virtual_item_value(const MENU *menu, int n)
+|
+|   Description   :  Return the selection value of the n'th item of a
+|                    virtual menu, whether or not it is in the page.
+|
+|   Return Values :  TRUE   - if item is selected
+|                    FALSE  - if item is not selected, or invalid n
++--------------------------------------------------------------------------*/
+NCURSES_EXPORT(bool)
+virtual_item_value(const MENU * menu, int n)
+{
+  bool result = FALSE;
+
+  T((T_CALLED("virtual_item_value(%p,%d)"), (const void *)menu, n));
+
+  if (menu && menu->virt && n >= 0 && n < menu->virt->count)
+    {
+      int first = Virtual_Index(menu);
+
+      if (n >= first && n < first + menu->nitems)
+	result = menu->items[n - first]->value;
+      else
+	result = Get_Value(menu->virt, n);
+    }
+  returnBool(result);
+}
+
+/* m_virtual.c ends here */
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2016,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -46,6 +46,10 @@
 extern "C" {
 #endif
 
+#ifndef NCURSES_MENU_INTERNALS
+#define NCURSES_MENU_INTERNALS /* nothing */
+#endif
+
 typedef int Menu_Options;
 typedef int Item_Options;
 
@@ -57,6 +61,8 @@ typedef int Item_Options;
 #define O_SHOWMATCH     (0x10)
 #define O_NONCYCLIC     (0x20)
 #define O_MOUSE_MENU    (0x40)
+#define O_SUBSTRING     (0x80)
+#define O_FUZZY         (0x100)
 
 /* Item options: */
 #define O_SELECTABLE    (0x01)
@@ -137,10 +143,19 @@ typedef struct tagMENU
 
   Menu_Options   opt;                   /* Menu options                    */
   unsigned short status;                /* Internal state of menu          */
+
+  /*
+   * The library keeps the page of a virtual menu and an index for pattern
+   * matching.  They follow the public members, since only the library
+   * allocates menus.
+   */
+  NCURSES_MENU_INTERNALS
 }
 #endif /* !NCURSES_OPAQUE_MENU */
 MENU;
 
+typedef const char * (*Menu_Text)(const MENU *, int);
+
 
 /* Define keys */
 
@@ -187,6 +202,7 @@ extern NCURSES_EXPORT(ITEM *)	current_item (const MENU *);
 extern NCURSES_EXPORT(ITEM *)	new_item (const char *,const char *);
 
 extern NCURSES_EXPORT(MENU *)	new_menu (ITEM **);
+extern NCURSES_EXPORT(MENU *)	new_virtual_menu (int, int, int, Menu_Text, Menu_Text);
 
 extern NCURSES_EXPORT(Item_Options)	item_opts (const ITEM *);
 extern NCURSES_EXPORT(Menu_Options)	menu_opts (const MENU *);
@@ -247,6 +263,7 @@ extern NCURSES_EXPORT(int)	set_menu_term (MENU *, Menu_Hook);
 extern NCURSES_EXPORT(int)	set_menu_userptr (MENU *,void *);
 extern NCURSES_EXPORT(int)	set_menu_win (MENU *,WINDOW *);
 extern NCURSES_EXPORT(int)	set_top_row (MENU *,int);
+extern NCURSES_EXPORT(int)	set_virtual_item (MENU *,int);
 extern NCURSES_EXPORT(int)	top_row (const MENU *);
 extern NCURSES_EXPORT(int)	unpost_menu (MENU *);
 extern NCURSES_EXPORT(int)	menu_request_by_name (const char *);
@@ -256,11 +273,13 @@ extern NCURSES_EXPORT(int)	menu_spacing (const MENU *,int *,int *,int *);
 
 extern NCURSES_EXPORT(bool)	item_value (const ITEM *);
 extern NCURSES_EXPORT(bool)	item_visible (const ITEM *);
+extern NCURSES_EXPORT(bool)	virtual_item_value (const MENU *,int);
 
 extern NCURSES_EXPORT(void)	menu_format (const MENU *,int *,int *);
 
 #if NCURSES_SP_FUNCS
 extern NCURSES_EXPORT(MENU *)	NCURSES_SP_NAME(new_menu) (SCREEN*, ITEM **);
+extern NCURSES_EXPORT(MENU *)	NCURSES_SP_NAME(new_virtual_menu) (SCREEN*, int, int, int, Menu_Text, Menu_Text);
 #endif
 
 #ifdef __cplusplus
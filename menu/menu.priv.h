@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2016,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -45,6 +45,11 @@
 
 #define NCURSES_OPAQUE_MENU 0
 
+/* The page of a virtual menu, and the index for pattern matching. */
+#define NCURSES_MENU_INTERNALS struct tagVIRTUAL *virt; \
+	struct tagMATCH *match;
+#define NCURSES_MENU_EXTENSION , (struct tagVIRTUAL *)0, (struct tagMATCH *)0
+
 #include "mf_common.h"
 #include "menu.h"
 
@@ -74,6 +79,7 @@ extern NCURSES_EXPORT_VAR(MENU) _nc_Default_Menu;
 /* menu specific status flags */
 #define _LINK_NEEDED    (0x04)
 #define _MARK_ALLOCATED (0x08)
+#define _SHOWN          (0x10)	/* window shows the menu as last drawn */
 
 #define ALL_MENU_OPTS (                 \
 		       O_ONEVALUE     | \
@@ -82,7 +88,12 @@ extern NCURSES_EXPORT_VAR(MENU) _nc_Default_Menu;
 		       O_IGNORECASE   | \
 		       O_SHOWMATCH    | \
 		       O_NONCYCLIC    | \
-		       O_MOUSE_MENU   )
+		       O_MOUSE_MENU   | \
+		       O_SUBSTRING    | \
+		       O_FUZZY        )
+
+/* the options which are on by default */
+#define DEFAULT_MENU_OPTS (ALL_MENU_OPTS & ~(O_SUBSTRING | O_FUZZY))
 
 #define ALL_ITEM_OPTS (O_SELECTABLE)
 
@@ -118,9 +129,73 @@ extern NCURSES_EXPORT_VAR(MENU) _nc_Default_Menu;
 
 #define UChar(c)	((unsigned char)(c))
 
+/* A virtual menu connects only one page of items at a time.  The page holds
+   whole rows of the row-major layout, starting with row "base".  The item
+   texts of the page are copies of what the callbacks returned, and the
+   selection values of the items which are not in the page are kept in a
+   bitmap.
+*/
+typedef struct tagVIRTUAL
+{
+  int            count;			/* Nr. of items in the menu        */
+  int            rows;			/* Nr. of rows of items            */
+  int            base;			/* First row in the page           */
+  int            size;			/* Nr. of items allocated for page */
+  Menu_Text      name;			/* Callbacks for the item texts    */
+  Menu_Text      desc;
+  ITEM          *pool;			/* Storage for the page items      */
+  ITEM         **page;			/* The page, as menu->items        */
+  char         **text;			/* Copies of name and description  */
+  unsigned char *values;		/* Selection values, if any        */
+}
+VIRTUAL;
+
+/* The index used for pattern matching (see m_match.c) is built when a
+   pattern is first matched.  It holds a copy of the item names, folded to
+   uppercase for O_IGNORECASE, and the names sorted so that the items with
+   a given prefix are a range.  The ranges for each prefix of the last
+   pattern are kept, so that each character narrows the previous range.
+   For O_SUBSTRING and O_FUZZY, the items which matched the last pattern
+   are kept, in order, and narrowed as the pattern grows.
+*/
+typedef struct
+{
+  const char    *name;			/* Name of an item                 */
+  int            item;			/* Index of the item               */
+}
+MATCH_NAME;
+
+typedef struct tagMATCH
+{
+  int            count;			/* Nr. of items indexed            */
+  bool           folded;		/* Names are folded to uppercase   */
+  int            longest;		/* Length of the longest name      */
+  char          *pool;			/* Storage for the names           */
+  int           *start;			/* Offset of each name in pool     */
+  MATCH_NAME    *sorted;		/* Names sorted, then by index     */
+  char          *key;			/* The pattern, folded             */
+  char          *prefix;		/* Last pattern matched as prefix  */
+  int            levels;		/* Its length                      */
+  int           *range;			/* Range in sorted for each prefix */
+  char          *pattern;		/* Last pattern used for found     */
+  int            length;		/* Its length, or -1               */
+  int            mode;			/* Match option used for found     */
+  int            nfound;		/* Nr. of items in found           */
+  int           *found;			/* Matching items, in order        */
+}
+MATCH;
+
+/* Offsets of the page within the items of a menu */
+#define Virtual_Row(menu)   ((menu)->virt ? (menu)->virt->base : 0)
+#define Virtual_Index(menu) (Virtual_Row(menu) * (menu)->cols)
+
+/* Total number of items, which for a virtual menu are not all connected */
+#define Item_Count(menu)    ((menu)->virt ? (menu)->virt->count : (menu)->nitems)
+
 /* Internal functions. */
 extern NCURSES_EXPORT(void) _nc_Draw_Menu (const MENU *);
-extern NCURSES_EXPORT(void) _nc_Show_Menu (const MENU *);
+extern NCURSES_EXPORT(void) _nc_Show_Menu (MENU *);
+extern NCURSES_EXPORT(void) _nc_Update_Menu (MENU *, int, const ITEM *);
 extern NCURSES_EXPORT(void) _nc_Calculate_Item_Length_and_Width (MENU *);
 extern NCURSES_EXPORT(int)  _nc_Calculate_Text_Width(const TEXT *);
 extern NCURSES_EXPORT(void) _nc_Post_Item (const MENU *, const ITEM *);
@@ -129,8 +204,17 @@ extern NCURSES_EXPORT(void) _nc_Disconnect_Items (MENU *);
 extern NCURSES_EXPORT(void) _nc_New_TopRow_and_CurrentItem (MENU *,int, ITEM *);
 extern NCURSES_EXPORT(void) _nc_Link_Items (MENU *);
 extern NCURSES_EXPORT(int)  _nc_Match_Next_Character_In_Item_Name (MENU*,int,ITEM**);
+extern NCURSES_EXPORT(int)  _nc_Match_Next_Character_In_Virtual_Menu (MENU*,int,int*);
 extern NCURSES_EXPORT(int)  _nc_menu_cursor_pos (const MENU* menu, const ITEM* item,
 				int* pY, int* pX);
+extern NCURSES_EXPORT(int)  _nc_Virtual_Format (MENU *, int, int);
+extern NCURSES_EXPORT(bool) _nc_Virtual_Driver (MENU *, int, int *);
+extern NCURSES_EXPORT(void) _nc_Virtual_Move (MENU *, int, int);
+extern NCURSES_EXPORT(void) _nc_Virtual_Adjust (MENU *, int);
+extern NCURSES_EXPORT(void) _nc_Virtual_Clear (MENU *);
+extern NCURSES_EXPORT(void) _nc_Free_Virtual (MENU *);
+extern NCURSES_EXPORT(int)  _nc_Find_Match (MENU *, int, int, bool);
+extern NCURSES_EXPORT(void) _nc_Free_Match (MENU *);
 
 #ifdef TRACE
 
@@ -125,6 +125,293 @@ get_escdelay(void)
 #endif
 #endif /* NCURSES_EXT_FUNCS */
 
+#if NCURSES_EXT_FUNCS
+/*
+ * Adaptive ESCDELAY.  Record the longest gap between the bytes of each
+ * key-sequence which completes, and wait for the next byte of a sequence only
+ * as long as a high percentile of those gaps (with some slack).  ESCDELAY
+ * remains the upper limit.
+ */
+#define ESCDELAY_PERCENT 98	/* percentile of the recorded gaps */
+#define ESCDELAY_FLOOR   10	/* shortest wait, in milliseconds */
+#define ESCDELAY_MINIMUM 8	/* samples needed before adapting */
+
+static void
+escdelay_sample(SCREEN *sp, long gap)
+{
+    short sorted[ESCDELAY_SAMPLES];
+    int count;
+
+    if (!sp->_escdelay_adapt)
+	return;
+
+    if (gap > GetEscdelay(sp))
+	gap = GetEscdelay(sp);
+    if (gap > SHRT_MAX)
+	gap = SHRT_MAX;
+    sp->_escdelay_gaps[sp->_escdelay_count++ % ESCDELAY_SAMPLES] = (short) gap;
+    if (sp->_escdelay_count >= 2 * ESCDELAY_SAMPLES)
+	sp->_escdelay_count -= ESCDELAY_SAMPLES;
+
+    count = sp->_escdelay_count;
+    if (count > ESCDELAY_SAMPLES)
+	count = ESCDELAY_SAMPLES;
+    if (count >= ESCDELAY_MINIMUM) {
+	int n, j, wait;
+
+	for (n = 0; n < count; ++n) {
+	    short value = sp->_escdelay_gaps[n];
+
+	    for (j = n; j > 0 && sorted[j - 1] > value; --j)
+		sorted[j] = sorted[j - 1];
+	    sorted[j] = value;
+	}
+	wait = sorted[((count * ESCDELAY_PERCENT) - 1) / 100];
+	wait += wait / 2;
+	if (wait < ESCDELAY_FLOOR)
+	    wait = ESCDELAY_FLOOR;
+	sp->_escdelay_adapted = wait;
+	TR(TRACE_IEVENT, ("adaptive escdelay %d from %d samples", wait, count));
+    }
+}
+
+/*
+ * A key-sequence timed out after we had used the adaptive delay.  If the byte
+ * which arrives next would have continued it, the gap is one which we should
+ * have waited for.
+ */
+static void
+escdelay_missed(SCREEN *sp, int ch)
+{
+    long gap = _nc_gettime(&(sp->_escdelay_miss_t0), FALSE);
+    TRIES *ptr = sp->_keytry;
+    int n;
+
+    for (n = 0; (ptr != 0) && (n < sp->_escdelay_miss_len); ++n) {
+	while ((ptr != 0) && (ptr->ch != sp->_escdelay_miss[n]))
+	    ptr = ptr->sibling;
+	if (ptr != 0)
+	    ptr = ptr->child;
+    }
+    sp->_escdelay_miss_len = 0;
+
+    while ((ptr != 0) && (ptr->ch != (unsigned char) ch))
+	ptr = ptr->sibling;
+    if (ptr != 0 && gap < GetEscdelay(sp)) {
+	TR(TRACE_IEVENT, ("late byte of key-sequence after %ld msecs", gap));
+	escdelay_sample(sp, gap);
+    }
+}
+
+/*
+ * Return the number of milliseconds to wait for the next byte of a
+ * key-sequence.
+ */
+static int
+escdelay_wait(SCREEN *sp)
+{
+    int result = GetEscdelay(sp);
+
+    if (sp->_escdelay_adapt
+	&& sp->_escdelay_adapted > 0
+	&& sp->_escdelay_adapted < result) {
+	result = sp->_escdelay_adapted;
+    }
+    return result;
+}
+
+/*
+ * Turn the adaptive ESCDELAY on or off, returning the previous setting.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_adaptive_escdelay) (NCURSES_SP_DCLx bool flag)
+{
+    int result = ERR;
+
+    T((T_CALLED("use_adaptive_escdelay(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0) {
+	result = SP_PARM->_escdelay_adapt;
+	SP_PARM->_escdelay_adapt = flag;
+	SP_PARM->_escdelay_count = 0;
+	SP_PARM->_escdelay_adapted = 0;
+	SP_PARM->_escdelay_miss_len = 0;
+    }
+    returnCode(result);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_adaptive_escdelay(bool flag)
+{
+    return NCURSES_SP_NAME(use_adaptive_escdelay) (CURRENT_SCREEN, flag);
+}
+#endif
+
+/*
+ * Input latency.  When enabled, note the time at which each byte is added to
+ * the fifo.  When a key is decoded, remember the time of its first byte, and
+ * when the key is returned from wgetch (or passed to the key callback), count
+ * the elapsed microseconds in a histogram with power-of-two buckets.
+ */
+static void
+latency_now(TimeType * t)
+{
+#if PRECISE_GETTIME
+    gettimeofday(t, (struct timezone *) 0);
+#else
+    *t = time((time_t *) 0);
+#endif
+}
+
+static bool
+latency_known(const TimeType * t)
+{
+#if PRECISE_GETTIME
+    return (t->tv_sec != 0 || t->tv_usec != 0);
+#else
+    return (*t != 0);
+#endif
+}
+
+static long
+latency_usecs(const TimeType * t0, const TimeType * t1)
+{
+    long result;
+#if PRECISE_GETTIME
+    long secs = (long) (t1->tv_sec - t0->tv_sec);
+
+    if (secs > LONG_MAX / 1000000 - 1)
+	secs = LONG_MAX / 1000000 - 1;
+    result = (secs * 1000000) + (long) (t1->tv_usec - t0->tv_usec);
+#else
+    result = (long) (*t1 - *t0) * 1000000;
+#endif
+    return (result < 0) ? 0 : result;
+}
+
+static NCURSES_INLINE void
+latency_stamp(SCREEN *sp, int slot)
+{
+    if (sp->_latency_stamp != 0)
+	latency_now(&(sp->_latency_stamp[slot]));
+}
+
+/*
+ * The key which is being decoded begins with the byte in the given slot.
+ * A mouse event may span several reports; keep the first.
+ */
+static NCURSES_INLINE void
+latency_mark(SCREEN *sp, int slot)
+{
+    if (sp->_latency_stamp != 0
+	&& !sp->_latency_pending
+	&& slot >= 0
+	&& latency_known(&(sp->_latency_stamp[slot]))) {
+	sp->_latency_t0 = sp->_latency_stamp[slot];
+	sp->_latency_pending = TRUE;
+    }
+}
+
+static void
+latency_record(SCREEN *sp, int ch)
+{
+    if (sp->_latency_stamp != 0 && sp->_latency_pending) {
+	TimeType t1;
+	long usecs;
+	int n;
+
+	latency_now(&t1);
+	usecs = latency_usecs(&(sp->_latency_t0), &t1);
+	for (n = 0; (n < LATENCY_BUCKETS - 1) && (usecs >> n) != 0; ++n) {
+	    ;
+	}
+	sp->_latency_hist[n] += 1;
+	TR(TRACE_IEVENT, ("input latency %ld usecs for %s",
+			  usecs, _nc_tracechar(sp, ch)));
+    }
+    (void) ch;
+    sp->_latency_pending = FALSE;
+}
+
+/*
+ * Turn the latency measurement on or off, returning the previous setting.
+ * Turning it on clears the histogram.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_input_latency) (NCURSES_SP_DCLx bool flag)
+{
+    int result = ERR;
+
+    T((T_CALLED("use_input_latency(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0) {
+	result = (SP_PARM->_latency_stamp != 0);
+	if (flag) {
+	    if (SP_PARM->_latency_stamp == 0) {
+		SP_PARM->_latency_stamp = typeCalloc(TimeType, FIFO_SIZE);
+		if (SP_PARM->_latency_stamp == 0)
+		    result = ERR;
+	    }
+	    memset(SP_PARM->_latency_hist, 0, sizeof(SP_PARM->_latency_hist));
+	} else {
+	    FreeAndNull(SP_PARM->_latency_stamp);
+	}
+	SP_PARM->_latency_pending = FALSE;
+    }
+    returnCode(result);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_input_latency(bool flag)
+{
+    return NCURSES_SP_NAME(use_input_latency) (CURRENT_SCREEN, flag);
+}
+#endif
+
+/*
+ * Copy the latency histogram to the caller's array of the given size, adding
+ * buckets which do not fit into the last entry.  Return the number of keys
+ * measured.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_input_latency) (NCURSES_SP_DCLx long *histogram, int size)
+{
+    int result = ERR;
+
+    T((T_CALLED("get_input_latency(%p,%p,%d)"),
+       (void *) SP_PARM, (void *) histogram, size));
+    if (SP_PARM != 0 && SP_PARM->_latency_stamp != 0) {
+	long total = 0;
+	int n;
+
+	if (histogram != 0 && size > 0)
+	    memset(histogram, 0, (size_t) size * sizeof(long));
+	for (n = 0; n < LATENCY_BUCKETS; ++n) {
+	    total += SP_PARM->_latency_hist[n];
+	    if (histogram != 0 && size > 0)
+		histogram[(n < size) ? n : (size - 1)] +=
+		    SP_PARM->_latency_hist[n];
+	}
+	result = (total > INT_MAX) ? INT_MAX : (int) total;
+    }
+    returnCode(result);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+get_input_latency(long *histogram, int size)
+{
+    return NCURSES_SP_NAME(get_input_latency) (CURRENT_SCREEN, histogram, size);
+}
+#endif
+#else
+#define escdelay_sample(sp, gap)	/* nothing */
+#define escdelay_wait(sp)		GetEscdelay(sp)
+#define latency_stamp(sp, slot)		/* nothing */
+#define latency_mark(sp, slot)		/* nothing */
+#define latency_record(sp, ch)		/* nothing */
+#endif /* NCURSES_EXT_FUNCS */
+
 static int
 _nc_use_meta(WINDOW *win)
 {
@@ -188,6 +475,56 @@ check_mouse_activity(SCREEN *sp, int delay EVENTLIST_2nd(_nc_eventlist * evl))
     return rc;
 }
 
+#if NCURSES_EXT_FUNCS && !defined(USE_TERM_DRIVER)
+/*
+ * Wait for input as check_mouse_activity() does, while servicing descriptors
+ * which the application registered with register_fd().  Keep waiting for the
+ * remainder of the delay unless a callback pushed a key with ungetch(), in
+ * which case return TW_USER.
+ */
+static int
+check_user_activity(SCREEN *sp, int delay EVENTLIST_2nd(_nc_eventlist * evl))
+{
+    int rc;
+
+#if USE_SYSMOUSE
+    if ((sp->_mouse_type == M_SYSMOUSE)
+	&& (sp->_sysmouse_head < sp->_sysmouse_tail)) {
+	return TW_MOUSE;
+    }
+#endif
+    for (;;) {
+	int timeleft = delay;
+
+	rc = _nc_timed_wait(sp,
+			    TWAIT_MASK | TW_USER,
+			    delay,
+			    &timeleft
+			    EVENTLIST_2nd(evl));
+	if (!(rc & TW_USER))
+	    break;
+	_nc_user_fd_dispatch(sp);
+	rc &= ~TW_USER;
+	if (rc != 0)
+	    break;
+	if (cooked_key_in_fifo()) {
+	    rc = TW_USER;
+	    break;
+	}
+	if (delay >= 0) {
+	    if (timeleft <= 0)
+		break;
+	    delay = timeleft;
+	}
+    }
+    return rc;
+}
+#else
+#define check_user_activity check_mouse_activity
+#endif
+
+#define fifo_next(n) (((n) >= FIFO_SIZE - 1) ? 0 : (n) + 1)
+
 static NCURSES_INLINE int
 fifo_peek(SCREEN *sp)
 {
@@ -205,6 +542,7 @@ fifo_pull(SCREEN *sp)
 
     TR(TRACE_IEVENT, ("pulling %s from %d", _nc_tracechar(sp, ch), head));
 
+    latency_mark(sp, head);
     if (peek == head) {
 	h_inc();
 	peek = head;
@@ -324,6 +662,7 @@ fifo_push(SCREEN *sp EVENTLIST_2nd(_nc_eventlist * evl))
 
     sp->_fifo[tail] = ch;
     sp->_fifohold = 0;
+    latency_stamp(sp, tail);
     if (head == -1)
 	head = peek = tail;
     t_inc();
@@ -422,10 +761,14 @@ _nc_wgetch(WINDOW *win,
     if (win == 0 || sp == 0) {
 	returnCode(ERR);
     }
+#if NCURSES_EXT_FUNCS
+    sp->_latency_pending = FALSE;
+#endif
 
     if (cooked_key_in_fifo()) {
 	recur_wrefresh(win);
 	*result = fifo_pull(sp);
+	latency_record(sp, *result);
 	returnCode(*result >= KEY_MIN ? KEY_CODE_YES : OK);
     }
 #ifdef NCURSES_WGETCH_EVENTS
@@ -475,7 +818,10 @@ _nc_wgetch(WINDOW *win,
 
     recur_wrefresh(win);
 
-    if (win->_notimeout || (win->_delay >= 0) || (sp->_cbreak > 1)) {
+    if (win->_notimeout
+	|| (win->_delay >= 0)
+	|| (sp->_cbreak > 1)
+	|| HasUserFds(sp)) {
 	if (head == -1) {	/* fifo is empty */
 	    int delay;
 
@@ -492,7 +838,7 @@ _nc_wgetch(WINDOW *win,
 
 	    TR(TRACE_IEVENT, ("delay is %d milliseconds", delay));
 
-	    rc = check_mouse_activity(sp, delay EVENTLIST_2nd(evl));
+	    rc = check_user_activity(sp, delay EVENTLIST_2nd(evl));
 
 #ifdef NCURSES_WGETCH_EVENTS
 	    if (rc & TW_EVENT) {
@@ -500,6 +846,11 @@ _nc_wgetch(WINDOW *win,
 		returnCode(KEY_CODE_YES);
 	    }
 #endif
+	    if (rc == TW_USER) {
+		*result = fifo_pull(sp);
+		latency_record(sp, *result);
+		returnCode(*result >= KEY_MIN ? KEY_CODE_YES : OK);
+	    }
 	    if (!rc) {
 		goto check_sigwinch;
 	    }
@@ -622,6 +973,7 @@ _nc_wgetch(WINDOW *win,
 	    ch &= 0x7f;
 
     T(("wgetch returning : %s", _nc_tracechar(sp, ch)));
+    latency_record(sp, ch);
 
     *result = ch;
     returnCode(ch >= KEY_MIN ? KEY_CODE_YES : OK);
@@ -667,9 +1019,10 @@ wgetch(WINDOW *win)
 **
 **      Get an input character, but take care of keypad sequences, returning
 **      an appropriate code when one matches the input.  After each character
-**      is received, set an alarm call based on ESCDELAY.  If no more of the
-**      sequence is received by the time the alarm goes off, pass through
-**      the sequence gotten so far.
+**      is received, set an alarm call based on ESCDELAY (or the adaptive
+**      delay), limited by the part of ESCDELAY which the sequence has not
+**      used yet.  If no more of the sequence is received by the time the
+**      alarm goes off, pass through the sequence gotten so far.
 **
 **	This function must be called when there are no cooked keys in queue.
 **	(that is head==-1 || peek==head)
@@ -682,9 +1035,20 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
     TRIES *ptr;
     int ch = 0;
     int timeleft = forever ? 9999999 : GetEscdelay(sp);
+    int length = 0;		/* number of bytes matched in the tries */
+    long longest = 0;		/* longest gap between those bytes */
+    bool limited = FALSE;	/* was the last wait shortened? */
+    TimeType t0;
 
     TR(TRACE_IEVENT, ("kgetch() called"));
 
+#ifdef NCURSES_WGETCH_EVENTS
+    /* resume the time budget of a sequence interrupted by a user event */
+    if (sp->_escdelay_left > 0 && !forever)
+	timeleft = sp->_escdelay_left;
+    sp->_escdelay_left = 0;
+#endif
+
     ptr = sp->_keytry;
 
     for (;;) {
@@ -701,6 +1065,10 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
 		peek = head;	/* the keys stay uninterpreted */
 		return fifo_pull(sp);	/* Remove KEY_EVENT from the queue */
 	    }
+#endif
+#if NCURSES_EXT_FUNCS
+	    if (sp->_escdelay_miss_len != 0)
+		escdelay_missed(sp, ch);
 #endif
 	}
 
@@ -726,9 +1094,13 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
 	}
 	TR(TRACE_IEVENT, ("ptr=%p, ch=%d, value=%d",
 			  (void *) ptr, ptr->ch, ptr->value));
+	++length;
 
 	if (ptr->value != 0) {	/* sequence terminated */
 	    TR(TRACE_IEVENT, ("end of sequence"));
+	    if (length > 1 && !forever)
+		escdelay_sample(sp, longest);
+	    latency_mark(sp, head);
 	    if (peek == tail) {
 		fifo_clear(sp);
 	    } else {
@@ -741,19 +1113,56 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
 
 	if (!raw_key_in_fifo()) {
 	    int rc;
+	    int wait = escdelay_wait(sp);
+	    long gap;
+
+	    /*
+	     * Wait for the next byte no longer than the (possibly adaptive)
+	     * escape-delay, nor than what remains of the budget for the whole
+	     * sequence.
+	     */
+	    limited = (!forever && wait < timeleft);
+	    if (!limited)
+		wait = timeleft;
 
 	    TR(TRACE_IEVENT, ("waiting for rest of sequence"));
-	    rc = check_mouse_activity(sp, timeleft EVENTLIST_2nd(evl));
+	    (void) _nc_gettime(&t0, TRUE);
+	    rc = check_mouse_activity(sp, wait EVENTLIST_2nd(evl));
+	    gap = _nc_gettime(&t0, FALSE);
+	    if (!forever) {
+		timeleft -= (int) gap;
+		if (timeleft < 0)
+		    timeleft = 0;
+	    }
+	    if (gap > longest)
+		longest = gap;
 #ifdef NCURSES_WGETCH_EVENTS
 	    if (rc & TW_EVENT) {
 		TR(TRACE_IEVENT, ("interrupted by a user event"));
-		/* FIXME Should have preserved remainder timeleft for reuse... */
+		sp->_escdelay_left = forever ? 0 : timeleft;
 		peek = head;	/* Restart interpreting later */
 		return KEY_EVENT;
 	    }
 #endif
 	    if (!rc) {
 		TR(TRACE_IEVENT, ("ran out of time"));
+#if NCURSES_EXT_FUNCS
+		if (limited && sp->_escdelay_adapt) {
+		    int n;
+
+		    /* remember the prefix, to check if the next byte is late */
+		    sp->_escdelay_miss_len = 0;
+		    sp->_escdelay_miss_t0 = t0;
+		    for (n = head;
+			 n != peek && sp->_escdelay_miss_len < ESCDELAY_PREFIX;
+			 n = fifo_next(n)) {
+			sp->_escdelay_miss[sp->_escdelay_miss_len++] =
+			    (unsigned char) sp->_fifo[n];
+		    }
+		    if (n != peek)
+			sp->_escdelay_miss_len = 0;
+		}
+#endif
 		break;
 	    }
 	}
@@ -762,3 +1171,511 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
     peek = head;
     return ch;
 }
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Callback-driven input.  Rather than blocking in wgetch(), the application
+ * passes bytes to feed_input(), or calls input_ready() when its own event loop
+ * finds the input descriptor readable.  Keys are decoded using the same fifo
+ * and function-key tries as kgetch(), and passed one at a time to the callback
+ * given in set_key_callback().  A partial key-sequence stays in the fifo until
+ * more bytes arrive, or until the application calls input_expire() from a
+ * timer which it armed using input_delay().
+ */
+/*
+ * Return the number of bytes which can be appended to the fifo.  We leave one
+ * slot unused, since only fifo_clear() can recover from the "full" state.
+ */
+static int
+fifo_room(SCREEN *sp)
+{
+    int result;
+
+    if (tail < 0) {
+	result = 0;
+    } else if (head < 0) {
+	result = FIFO_SIZE - 1;
+    } else {
+	result = (FIFO_SIZE) - 1 - ((tail - head + (FIFO_SIZE)) % (FIFO_SIZE));
+    }
+    return result;
+}
+
+static void
+fifo_append(SCREEN *sp, int ch)
+{
+    sp->_fifo[tail] = ch;
+    sp->_fifohold = 0;
+    latency_stamp(sp, tail);
+    if (head == -1)
+	head = peek = tail;
+    t_inc();
+    TR(TRACE_IEVENT, ("appended %s at %d", _nc_tracechar(sp, ch), tail));
+}
+
+/*
+ * The function-key tries matched kmous.  Check if the remainder of the xterm
+ * mouse report is in the fifo, where _nc_mouse_inline() will read it using
+ * _nc_fifo_read().
+ */
+static bool
+mouse_report_ready(SCREEN *sp)
+{
+    bool result = TRUE;
+
+    if (sp->_mouse_type == M_XTERM) {
+	int need = (sp->_mouse_format == MF_SGR1006) ? -1 : 3;
+	int have = 0;
+	int n;
+
+	result = FALSE;
+	for (n = peek; n != tail; n = fifo_next(n)) {
+	    int ch = sp->_fifo[n];
+
+	    ++have;
+	    if (need < 0) {
+		/* the parameters of an SGR 1006 report end with a final byte */
+		if ((ch >= 0x40 && ch <= 0x7e) || (have >= 80)) {
+		    result = TRUE;
+		    break;
+		}
+	    } else {
+#ifdef EXP_XTERM_1005
+		/* the coordinates of a 1005 report are UTF-8 encoded */
+		if (sp->_mouse_format == MF_XTERM_1005
+		    && have > 1
+		    && (ch & 0xc0) == 0xc0) {
+		    need += (ch & 0x20) ? ((ch & 0x10) ? 3 : 2) : 1;
+		}
+#endif
+		if (have >= need) {
+		    result = TRUE;
+		    break;
+		}
+	    }
+	}
+    }
+    return result;
+}
+
+/*
+ * Like kgetch(), but do not wait for the remainder of a key-sequence.  Return
+ * ERR if the fifo holds only a prefix of a sequence, unless "expired" is set,
+ * which tells us to pass through the sequence gotten so far.
+ */
+static int
+kgetch_nowait(SCREEN *sp, bool expired)
+{
+    TRIES *ptr = sp->_keytry;
+    int length = 0;
+    int ch;
+
+    TR(TRACE_IEVENT, ("kgetch_nowait(%d) called", expired));
+
+    for (;;) {
+	if (!raw_key_in_fifo()) {
+	    if (!expired) {
+		TR(TRACE_IEVENT, ("waiting for rest of sequence"));
+		peek = head;
+		return ERR;
+	    }
+	    TR(TRACE_IEVENT, ("ran out of time"));
+	    break;
+	}
+
+	ch = fifo_peek(sp);
+	TR(TRACE_IEVENT, ("ch: %s", _nc_tracechar(sp, (unsigned char) ch)));
+	while ((ptr != NULL) && (ptr->ch != (unsigned char) ch))
+	    ptr = ptr->sibling;
+
+	if (ptr == NULL) {
+	    TR(TRACE_IEVENT, ("ptr is null"));
+	    break;
+	}
+	++length;
+
+	if (ptr->value != 0) {	/* sequence terminated */
+	    if (ptr->value == KEY_MOUSE
+		&& !expired
+		&& !mouse_report_ready(sp)) {
+		TR(TRACE_IEVENT, ("waiting for rest of mouse report"));
+		peek = head;
+		return ERR;
+	    }
+	    TR(TRACE_IEVENT, ("end of sequence"));
+	    if (length > 1)
+		escdelay_sample(sp, sp->_key_gap);
+	    latency_mark(sp, head);
+	    if (peek == tail) {
+		fifo_clear(sp);
+	    } else {
+		head = peek;
+	    }
+	    return (ptr->value);
+	}
+
+	ptr = ptr->child;
+    }
+    ch = fifo_pull(sp);
+    peek = head;
+    return ch;
+}
+
+/*
+ * Decode the keys in the fifo, passing each to the callback.  Stop if the
+ * callback returns ERR, leaving the remaining input in the fifo.  Return the
+ * number of keys passed to the callback.
+ */
+static int
+dispatch_keys(SCREEN *sp, bool expired)
+{
+    int count = 0;
+
+    sp->_key_pending = FALSE;
+    while (sp->_key_callback != 0) {
+	int ch;
+
+	sp->_latency_pending = FALSE;
+	if (cooked_key_in_fifo()) {
+	    ch = fifo_pull(sp);
+	} else if (!raw_key_in_fifo()) {
+	    break;
+	} else if (sp->_keypad_on) {
+	    if ((ch = kgetch_nowait(sp, expired)) == ERR) {
+		sp->_key_pending = TRUE;
+		break;
+	    }
+	    sp->_key_gap = 0;
+	    /*
+	     * There is no wait for further mouse events here, so clicks are
+	     * composed only from the events already decoded.
+	     */
+	    if (ch == KEY_MOUSE
+		&& !sp->_mouse_inline(sp)
+		&& sp->_maxclick >= 0) {
+		sp->_mouse_parse(sp, 1);
+	    }
+	} else {
+	    ch = fifo_pull(sp);
+	}
+
+	/* as in _nc_wgetch(), simulate ICRNL mode and strip the 8th bit */
+	if ((ch == '\r') && sp->_nl)
+	    ch = '\n';
+	if (!sp->_use_meta)
+	    if ((ch < KEY_MIN) && (ch & 0x80))
+		ch &= 0x7f;
+
+	T(("key callback gets %s", _nc_tracechar(sp, ch)));
+	latency_record(sp, ch);
+	++count;
+	if (sp->_key_callback(sp, ch, sp->_key_cb_data) == ERR)
+	    break;
+    }
+    return count;
+}
+
+/*
+ * Append the bytes to the fifo, dispatching keys whenever it fills.  Return
+ * the number of bytes used.
+ */
+static int
+feed_bytes(SCREEN *sp, const char *buffer, int length)
+{
+    bool was_pending = sp->_key_pending;
+    int count = 0;
+    int n;
+
+    if (was_pending) {
+	long gap = _nc_gettime(&(sp->_key_pending_t0), FALSE);
+
+	if (gap > sp->_key_gap)
+	    sp->_key_gap = gap;
+    }
+    for (n = 0; n < length; ++n) {
+	if (fifo_room(sp) == 0) {
+	    count += dispatch_keys(sp, FALSE);
+	    if (fifo_room(sp) == 0)
+		count += dispatch_keys(sp, TRUE);
+	    if (fifo_room(sp) == 0)
+		break;
+	}
+	fifo_append(sp, UChar(buffer[n]));
+    }
+    count += dispatch_keys(sp, FALSE);
+    if (n != 0 && sp->_key_pending) {
+	/* a sequence which began in this call has the whole ESCDELAY */
+	if (!was_pending || count != 0) {
+	    (void) _nc_gettime(&(sp->_key_start_t0), TRUE);
+	    sp->_key_gap = 0;
+	}
+	(void) _nc_gettime(&(sp->_key_pending_t0), TRUE);
+    }
+    return n;
+}
+
+/*
+ * Read the remainder of a mouse report which feed_input() or wget_wchs()
+ * placed in the fifo.  Like read(), return -1 if there is nothing left.
+ */
+NCURSES_EXPORT(int)
+_nc_fifo_read(SCREEN *sp, char *buffer, size_t length)
+{
+    size_t n = 0;
+
+    while (n < length && !cooked_key_in_fifo() && raw_key_in_fifo()) {
+	buffer[n++] = (char) fifo_pull(sp);
+    }
+    return (n != 0) ? (int) n : -1;
+}
+
+#if USE_WIDEC_SUPPORT
+/*
+ * Append the input which is available without waiting to the fifo, using a
+ * single read() rather than one for each byte.
+ */
+static void
+fifo_fill(SCREEN *sp)
+{
+#ifndef USE_TERM_DRIVER
+    int room = fifo_room(sp);
+
+    if (room > 0
+	&& (_nc_timed_wait(sp, TW_INPUT, 0, (int *) 0
+			   EVENTLIST_2nd((_nc_eventlist *) 0)) & TW_INPUT)) {
+	char buffer[FIFO_SIZE];
+	int n = (int) read(sp->_ifd, buffer, (size_t) room);
+	int k;
+
+	TR(TRACE_IEVENT, ("read(%d,buffer,%d)=%d", sp->_ifd, room, n));
+	for (k = 0; k < n; ++k)
+	    fifo_append(sp, UChar(buffer[k]));
+    }
+#else
+    (void) sp;
+#endif
+}
+
+/*
+ * Check if the byte may begin a function-key sequence.
+ */
+static bool
+key_prefix(SCREEN *sp, int ch)
+{
+    TRIES *ptr;
+
+    for (ptr = sp->_keytry; ptr != 0; ptr = ptr->sibling) {
+	if (ptr->ch == (unsigned char) ch)
+	    return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * Batched input for wget_wchs() in a UTF-8 locale.  Fill the fifo with what
+ * is available, and decode complete characters directly from it, stopping
+ * before anything which may begin a function-key sequence (or is not valid
+ * UTF-8), so that wgetch() handles that.  Return the number of characters.
+ */
+NCURSES_EXPORT(int)
+_nc_fifo_utf8(SCREEN *sp, wint_t *buffer, int length)
+{
+    int count = 0;
+
+    if (cooked_key_in_fifo())
+	return 0;
+
+    fifo_fill(sp);
+    while (count < length && tail >= 0 && raw_key_in_fifo()) {
+	int n = head;
+	int ch = sp->_fifo[n];
+	int need;
+	int have;
+	unsigned value;
+
+	if (ch < 0
+	    || ch >= KEY_MIN
+	    || (sp->_keypad_on && key_prefix(sp, ch))
+	    || (need = UTF8_LENGTH(ch)) == 0) {
+	    break;
+	}
+	value = (need > 1) ? UTF8_LEAD(ch, need) : (unsigned) ch;
+	for (have = 1; have < need; ++have) {
+	    n = fifo_next(n);
+	    if (n == tail || !UTF8_CONT(sp->_fifo[n]))
+		break;
+	    value = (value << 6) | (unsigned) (sp->_fifo[n] & 0x3f);
+	}
+	if (have < need || !UTF8_VALID(value, need))
+	    break;
+
+	while (have-- > 0) {
+	    h_inc();
+	}
+	peek = head;
+
+	if ((value == '\r') && sp->_nl)
+	    value = '\n';
+	buffer[count++] = (wint_t) value;
+    }
+    TR(TRACE_IEVENT, ("decoded %d characters from the fifo", count));
+    return count;
+}
+#endif /* USE_WIDEC_SUPPORT */
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(set_key_callback) (NCURSES_SP_DCLx
+				   NCURSES_KEY_CB callback,
+				   void *data)
+{
+    int code = ERR;
+    TR_FUNC_BFR(1);
+
+    T((T_CALLED("set_key_callback(%p,%s,%p)"),
+       (void *) SP_PARM,
+       TR_FUNC_ARG(0, callback),
+       data));
+
+    if (SP_PARM != 0) {
+	SP_PARM->_key_callback = callback;
+	SP_PARM->_key_cb_data = data;
+	SP_PARM->_key_pending = FALSE;
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+set_key_callback(NCURSES_KEY_CB callback, void *data)
+{
+    return NCURSES_SP_NAME(set_key_callback) (CURRENT_SCREEN, callback, data);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(feed_input) (NCURSES_SP_DCLx const char *buffer, int length)
+{
+    int code = ERR;
+
+    T((T_CALLED("feed_input(%p,%p,%d)"), (void *) SP_PARM, buffer, length));
+
+    if (SP_PARM != 0
+	&& SP_PARM->_key_callback != 0
+	&& buffer != 0
+	&& length >= 0) {
+	code = feed_bytes(SP_PARM, buffer, length);
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+feed_input(const char *buffer, int length)
+{
+    return NCURSES_SP_NAME(feed_input) (CURRENT_SCREEN, buffer, length);
+}
+#endif
+
+/*
+ * The application's event loop found the input descriptor readable.  Read
+ * what is available (one read will not block), and decode it.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(input_ready) (NCURSES_SP_DCL0)
+{
+    int code = ERR;
+
+    T((T_CALLED("input_ready(%p)"), (void *) SP_PARM));
+
+    if (SP_PARM != 0 && SP_PARM->_key_callback != 0) {
+	char buffer[FIFO_SIZE];
+	int n;
+
+	if (fifo_room(SP_PARM) == 0)
+	    dispatch_keys(SP_PARM, FALSE);
+#ifdef USE_TERM_DRIVER
+	{
+	    int buf;
+	    n = CallDriver_1(SP_PARM, td_read, &buf);
+	    buffer[0] = (char) buf;
+	}
+#else
+	n = (int) read(SP_PARM->_ifd, buffer, (size_t) fifo_room(SP_PARM));
+#endif
+	TR(TRACE_IEVENT, ("read(%d,buffer)=%d", SP_PARM->_ifd, n));
+	if (n > 0)
+	    code = feed_bytes(SP_PARM, buffer, n);
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+input_ready(void)
+{
+    return NCURSES_SP_NAME(input_ready) (CURRENT_SCREEN);
+}
+#endif
+
+/*
+ * Return the number of milliseconds until input_expire() should be called,
+ * or -1 if there is no partial key-sequence.  As in kgetch(), that is the
+ * (possibly adaptive) wait since the last byte, limited by what remains of
+ * ESCDELAY since the first.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(input_delay) (NCURSES_SP_DCL0)
+{
+    int code = -1;
+
+    T((T_CALLED("input_delay(%p)"), (void *) SP_PARM));
+
+    if (SP_PARM != 0 && SP_PARM->_key_pending) {
+	long first = _nc_gettime(&(SP_PARM->_key_start_t0), FALSE);
+	long last = _nc_gettime(&(SP_PARM->_key_pending_t0), FALSE);
+	int wait = escdelay_wait(SP_PARM) - (int) last;
+
+	code = GetEscdelay(SP_PARM) - (int) first;
+	if (wait < code)
+	    code = wait;
+	if (code < 0)
+	    code = 0;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+input_delay(void)
+{
+    return NCURSES_SP_NAME(input_delay) (CURRENT_SCREEN);
+}
+#endif
+
+/*
+ * The timer for a partial key-sequence expired: pass through the bytes
+ * gotten so far, as kgetch() does when ESCDELAY runs out.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(input_expire) (NCURSES_SP_DCL0)
+{
+    int code = ERR;
+
+    T((T_CALLED("input_expire(%p)"), (void *) SP_PARM));
+
+    if (SP_PARM != 0 && SP_PARM->_key_callback != 0) {
+	dispatch_keys(SP_PARM, TRUE);
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+input_expire(void)
+{
+    return NCURSES_SP_NAME(input_expire) (CURRENT_SCREEN);
+}
+#endif
+#endif /* NCURSES_EXT_FUNCS */
@@ -948,6 +948,29 @@ handle_wheel(SCREEN *sp, MEVENT * eventp, int button, int wheel)
     return result;
 }
 
+/*
+ * Read the remainder of an xterm mouse report.  Callback-driven input (see
+ * feed_input) has already placed it in the fifo, and batched reads (see
+ * wget_wchs) may have done that.
+ */
+static int
+read_report(SCREEN *sp, void *buffer, size_t length)
+{
+#if NCURSES_EXT_FUNCS
+    int result = _nc_fifo_read(sp, (char *) buffer, length);
+
+    if (result > 0 || sp->_key_callback != 0)
+	return result;
+#endif
+    return (int) read(
+#if USE_EMX_MOUSE
+			 (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
+#else
+			 sp->_ifd,
+#endif
+			 buffer, length);
+}
+
 static bool
 decode_X10_bstate(SCREEN *sp, MEVENT * eventp, unsigned intro)
 {
@@ -1042,13 +1065,8 @@ decode_xterm_X10(SCREEN *sp, MEVENT * eventp)
     for (grabbed = 0; grabbed < MAX_KBUF; grabbed += (size_t) res) {
 
 	/* For VIO mouse we add extra bit 64 to disambiguate button-up. */
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    kbuf + grabbed, (size_t) (MAX_KBUF - (int) grabbed));
+	res = read_report(sp, kbuf + grabbed,
+			  (size_t) (MAX_KBUF - (int) grabbed));
 	if (res == -1)
 	    break;
     }
@@ -1097,13 +1115,7 @@ decode_xterm_1005(SCREEN *sp, MEVENT * eventp)
     for (grabbed = 0; grabbed < limit;) {
 	int res;
 
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    (kbuf + grabbed), (size_t) 1);
+	res = read_report(sp, (kbuf + grabbed), (size_t) 1);
 	if (res == -1)
 	    break;
 	grabbed += (size_t) res;
@@ -1182,13 +1194,7 @@ read_SGR(SCREEN *sp, SGR_DATA * result)
     do {
 	int res;
 
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    (kbuf + grabbed), (size_t) 1);
+	res = read_report(sp, (kbuf + grabbed), (size_t) 1);
 	if (res == -1)
 	    break;
 	if ((grabbed + MAX_KBUF) >= (int) sizeof(kbuf)) {
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2017,2018 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2018,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -190,6 +190,16 @@ delscreen(SCREEN *sp)
 	FreeIfNeeded(sp->_acs_map);
 	FreeIfNeeded(sp->_screen_acs_map);
 
+	if (sp->_panelHook.free_index != 0) {
+	    sp->_panelHook.free_index(sp->_panelHook.panel_index);
+	    sp->_panelHook.panel_index = 0;
+	}
+
+#if NCURSES_EXT_FUNCS
+	_nc_free_user_fds(sp);
+	FreeIfNeeded(sp->_latency_stamp);
+#endif
+
 	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
 	NCURSES_SP_NAME(del_curterm) (NCURSES_SP_ARGx sp->_term);
 	FreeIfNeeded(sp->out_buffer);
@@ -74,6 +74,11 @@ safe_ungetch(SCREEN *sp, int ch)
 	}
 
 	sp->_fifo[head] = ch;
+#if NCURSES_EXT_FUNCS
+	/* this is not input, so there is no latency to measure */
+	if (sp->_latency_stamp != 0)
+	    memset(&(sp->_latency_stamp[head]), 0, sizeof(TimeType));
+#endif
 	T(("ungetch %s ok", _nc_tracechar(sp, ch)));
 #ifdef TRACE
 	if (USE_TRACEF(TRACE_IEVENT)) {
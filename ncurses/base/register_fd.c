@@ -0,0 +1,215 @@
+/****************************************************************************
+ * Copyright (c) 2020 Free Software Foundation, Inc.                        *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/*
+**	register_fd.c
+**
+**	The routines register_fd(), unregister_fd().
+**
+*/
+
+#include <curses.priv.h>
+
+#if !USE_FUNC_POLL && HAVE_SELECT
+# if HAVE_SYS_TIME_H && HAVE_SYS_TIME_SELECT
+#  include <sys/time.h>
+# endif
+# if HAVE_SYS_SELECT_H
+#  include <sys/select.h>
+# endif
+#endif
+
+MODULE_ID("$Id: register_fd.c,v 1.1 2020/01/25 00:00:00 tom Exp $")
+
+/*
+ * When _nc_timed_wait() uses select(), each descriptor must fit in an fd_set.
+ */
+#if !USE_FUNC_POLL && HAVE_SELECT
+#define ValidUserFd(fd) ((fd) >= 0 && (fd) < FD_SETSIZE)
+#else
+#define ValidUserFd(fd) ((fd) >= 0)
+#endif
+
+static int
+find_user_fd(SCREEN *sp, int fd)
+{
+    int n;
+
+    for (n = 0; n < sp->_user_fd_count; ++n) {
+	if (sp->_user_fds[n].fd == fd)
+	    return n;
+    }
+    return -1;
+}
+
+static void
+remove_user_fd(SCREEN *sp, int n)
+{
+    while (++n < sp->_user_fd_count) {
+	sp->_user_fds[n - 1] = sp->_user_fds[n];
+    }
+    if (--(sp->_user_fd_count) == 0) {
+	FreeAndNull(sp->_user_fds);
+    }
+    sp->_user_fd_dirty = TRUE;
+}
+
+/*
+ * Ask wgetch() to watch the given file descriptor while it waits for input,
+ * calling the callback each time the descriptor becomes readable.  The
+ * callback may use ungetch() to make wgetch() return a value; otherwise
+ * wgetch() continues to wait for the remainder of its timeout.  A callback
+ * which returns ERR is unregistered.
+ *
+ * Registering a descriptor a second time replaces its callback and data.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(register_fd) (NCURSES_SP_DCLx
+			      int fd,
+			      NCURSES_FD_CB callback,
+			      void *data)
+{
+    int code = ERR;
+    TR_FUNC_BFR(1);
+
+    T((T_CALLED("register_fd(%p,%d,%s,%p)"),
+       (void *) SP_PARM,
+       fd,
+       TR_FUNC_ARG(0, callback),
+       data));
+
+#ifdef USE_TERM_DRIVER
+    (void) fd;
+    (void) callback;
+    (void) data;
+#else
+    if (SP_PARM != 0 && ValidUserFd(fd) && callback != 0) {
+	int n = find_user_fd(SP_PARM, fd);
+
+	if (n < 0) {
+	    USER_FD *list = typeRealloc(USER_FD,
+					SP_PARM->_user_fd_count + 1,
+					SP_PARM->_user_fds);
+	    if (list != 0) {
+		SP_PARM->_user_fds = list;
+		n = SP_PARM->_user_fd_count++;
+		SP_PARM->_user_fd_dirty = TRUE;
+	    } else {
+		SP_PARM->_user_fd_count = 0;
+	    }
+	}
+	if (n >= 0) {
+	    SP_PARM->_user_fds[n].fd = fd;
+	    SP_PARM->_user_fds[n].callback = callback;
+	    SP_PARM->_user_fds[n].data = data;
+	    SP_PARM->_user_fds[n].ready = FALSE;
+	    code = OK;
+	}
+    }
+#endif
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+register_fd(int fd, NCURSES_FD_CB callback, void *data)
+{
+    return NCURSES_SP_NAME(register_fd) (CURRENT_SCREEN, fd, callback, data);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(unregister_fd) (NCURSES_SP_DCLx int fd)
+{
+    int code = ERR;
+
+    T((T_CALLED("unregister_fd(%p,%d)"), (void *) SP_PARM, fd));
+
+    if (SP_PARM != 0) {
+	int n = find_user_fd(SP_PARM, fd);
+
+	if (n >= 0) {
+	    remove_user_fd(SP_PARM, n);
+	    code = OK;
+	}
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+unregister_fd(int fd)
+{
+    return NCURSES_SP_NAME(unregister_fd) (CURRENT_SCREEN, fd);
+}
+#endif
+
+/*
+ * Call the callbacks for descriptors which _nc_timed_wait() found readable.
+ * A callback may register or unregister descriptors, so rescan the list after
+ * each call rather than keeping an index into it.
+ */
+NCURSES_EXPORT(void)
+_nc_user_fd_dispatch(SCREEN *sp)
+{
+    bool found;
+
+    do {
+	int n;
+
+	found = FALSE;
+	for (n = 0; n < sp->_user_fd_count; ++n) {
+	    USER_FD *p = &(sp->_user_fds[n]);
+
+	    if (p->ready) {
+		int fd = p->fd;
+
+		p->ready = FALSE;
+		found = TRUE;
+		TR(TRACE_IEVENT, ("user descriptor %d is readable", fd));
+		if (p->callback(fd, p->data) == ERR
+		    && (n = find_user_fd(sp, fd)) >= 0) {
+		    remove_user_fd(sp, n);
+		}
+		break;
+	    }
+	}
+    } while (found);
+}
+
+NCURSES_EXPORT(void)
+_nc_free_user_fds(SCREEN *sp)
+{
+    FreeAndNull(sp->_user_fds);
+    sp->_user_fd_count = 0;
+#if USE_EPOLL
+    if (sp->_epoll_fd >= 0)
+	close(sp->_epoll_fd);
+    sp->_epoll_fd = -1;
+#endif
+}
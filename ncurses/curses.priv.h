@@ -316,6 +316,10 @@ typedef TRIES {
 #define MAXLINES      66
 #define FIFO_SIZE     MAXCOLUMNS+2  /* for nocbreak mode input */
 
+#define ESCDELAY_SAMPLES 64	/* gaps recorded for the adaptive ESCDELAY */
+#define ESCDELAY_PREFIX  8	/* longest timed-out prefix to check */
+#define LATENCY_BUCKETS  24	/* histogram of use_input_latency() */
+
 #define ACS_LEN       128
 
 #define WINDOWLIST struct _win_list
@@ -685,6 +689,9 @@ extern NCURSES_EXPORT(int) _nc_sigprocmask(int, const sigset_t *, sigset_t *);
 #endif
 
 #if HAVE_GETTIMEOFDAY
+# if HAVE_SYS_TIME_H
+#  include <sys/time.h>
+# endif
 # define PRECISE_GETTIME 1
 # define TimeType struct timeval
 #else
@@ -815,6 +822,30 @@ typedef int (*TYPE_Gpm_GetEvent) (Gpm_Event *);
 #endif /* HAVE_LIBDL */
 #endif /* USE_GPM_SUPPORT */
 
+/*
+ * Descriptors registered with register_fd() are serviced while wgetch() waits
+ * for input.  Where epoll is available, _nc_timed_wait() keeps them with the
+ * input and mouse descriptors in a persistent set rather than rebuilding its
+ * list on each call.
+ */
+#if NCURSES_EXT_FUNCS
+typedef struct {
+	int	fd;
+	NCURSES_FD_CB callback;
+	void	*data;
+	bool	ready;		/* set by _nc_timed_wait() */
+} USER_FD;
+
+#if HAVE_SYS_EPOLL_H && !defined(USE_TERM_DRIVER)
+#include <sys/epoll.h>
+#define USE_EPOLL 1
+#endif
+#endif /* NCURSES_EXT_FUNCS */
+
+#ifndef USE_EPOLL
+#define USE_EPOLL 0
+#endif
+
 typedef struct {
     long sequence;
     bool last_used;
@@ -1382,6 +1413,38 @@ struct screen {
 	int		_recent_pair;	/* number for most recent free-pair  */
 #endif
 
+#if NCURSES_EXT_FUNCS
+	USER_FD		*_user_fds;	/* descriptors from register_fd()    */
+	int		_user_fd_count;	/* number of entries in _user_fds    */
+	bool		_user_fd_dirty;	/* set of descriptors has changed    */
+	NCURSES_KEY_CB	_key_callback;	/* from set_key_callback()	     */
+	void		*_key_cb_data;	/* ...its client data		     */
+	bool		_key_pending;	/* fifo holds a partial key-sequence */
+	TimeType	_key_pending_t0; /* ...when its last byte arrived    */
+	TimeType	_key_start_t0;	/* ...when its first byte arrived    */
+	long		_key_gap;	/* ...longest gap between its bytes  */
+
+	bool		_escdelay_adapt; /* use_adaptive_escdelay()	     */
+	int		_escdelay_adapted; /* computed delay, if nonzero    */
+	int		_escdelay_count; /* number of gaps recorded	     */
+	short		_escdelay_gaps[ESCDELAY_SAMPLES];
+	int		_escdelay_miss_len; /* prefix of a timed-out sequence */
+	unsigned char	_escdelay_miss[ESCDELAY_PREFIX];
+	TimeType	_escdelay_miss_t0; /* ...when its last byte arrived */
+
+	TimeType	*_latency_stamp; /* when each byte of the fifo was read */
+	TimeType	_latency_t0;	/* ...the first byte of the current key */
+	bool		_latency_pending; /* ...which _latency_t0 holds	     */
+	long		_latency_hist[LATENCY_BUCKETS];
+#endif
+#ifdef NCURSES_WGETCH_EVENTS
+	int		_escdelay_left;	/* budget of an interrupted sequence */
+#endif
+#if USE_EPOLL
+	int		_epoll_fd;	/* persistent set for _nc_timed_wait */
+	int		_epoll_mouse;	/* value of _mouse_fd in that set    */
+#endif
+
 #ifdef TRACE
 	char		tracechr_buf[40];
 	char		tracemse_buf[TRACEMSE_MAX];
@@ -1415,6 +1478,12 @@ extern NCURSES_EXPORT_VAR(SIG_ATOMIC_T) _nc_have_sigwinch;
 #define SP_INIT_WINDOWLIST(sp)	/* nothing */
 #endif
 
+#if USE_EPOLL
+#define SP_INIT_EPOLL(sp)	sp->_epoll_fd = -1
+#else
+#define SP_INIT_EPOLL(sp)	/* nothing */
+#endif
+
 #define SP_PRE_INIT(sp)                         \
     sp->_cursrow = -1;                          \
     sp->_curscol = -1;                          \
@@ -1426,6 +1495,7 @@ extern NCURSES_EXPORT_VAR(SIG_ATOMIC_T) _nc_have_sigwinch;
     sp->_endwin = ewSuspend;                    \
     sp->_cursor = -1;                           \
     SP_INIT_WINDOWLIST(sp);                     \
+    SP_INIT_EPOLL(sp);                          \
     sp->_outch = NCURSES_OUTC_FUNC;             \
     sp->jump = 0                                \
 
@@ -1618,6 +1688,25 @@ extern NCURSES_EXPORT_VAR(SIG_ATOMIC_T) _nc_have_sigwinch;
 			     _nc_is_charable(CharOf(ch)))
 
 #define L(ch)		L ## ch
+
+	/*
+	 * Inline UTF-8 decoding, used for input when the screen's locale is
+	 * UTF-8, rather than calling mbrtowc() for each byte.  UTF8_LENGTH()
+	 * is zero for bytes which cannot begin a character, including those
+	 * which would begin an overlong two-byte form.
+	 */
+#define UTF8_LENGTH(c)	(((c) < 0x80) ? 1 :				\
+			 ((c) < 0xc2) ? 0 :				\
+			 ((c) < 0xe0) ? 2 :				\
+			 ((c) < 0xf0) ? 3 :				\
+			 ((c) < 0xf5) ? 4 : 0)
+#define UTF8_LEAD(c,n)	((unsigned) (c) & (0xffU >> ((n) + 1)))
+#define UTF8_CONT(c)	(((c) & 0xc0) == 0x80)
+#define UTF8_VALID(v,n)	(((n) == 3)					\
+			 ? ((v) >= 0x800 && ((v) < 0xd800 || (v) > 0xdfff)) \
+			 : (((n) == 4)					\
+			    ? ((v) >= 0x10000 && (v) <= 0x10ffff)	\
+			    : TRUE))
 #else /* }{ */
 #define CharOf(c)	ChCharOf(c)
 #define AttrOf(c)	ChAttrOf(c)
@@ -2194,6 +2283,9 @@ extern NCURSES_EXPORT(int)    _nc_ripoffline(int, int(*)(WINDOW*, int));
 					    ExitTerminfo(EXIT_FAILURE);\
 					}
 
+/* lib_ti.c */
+extern NCURSES_EXPORT(void) _nc_free_ext_index(TERMINAL *);
+
 /* lib_tstp.c */
 #if USE_SIGWINCH
 extern NCURSES_EXPORT(int) _nc_handle_sigwinch(SCREEN *);
@@ -2257,6 +2349,7 @@ extern NCURSES_EXPORT(int) _nc_read_termcap_entry (const char *const, TERMTYPE2
 extern NCURSES_EXPORT(int) _nc_setup_tinfo(const char *, TERMTYPE2 *);
 extern NCURSES_EXPORT(int) _nc_setupscreen (int, int, FILE *, int, int);
 extern NCURSES_EXPORT(int) _nc_timed_wait (SCREEN *, int, int, int * EVENTLIST_2nd(_nc_eventlist *));
+extern NCURSES_EXPORT(long) _nc_gettime (TimeType *, int);
 extern NCURSES_EXPORT(void) _nc_init_termtype (TERMTYPE2 *const);
 extern NCURSES_EXPORT(void) _nc_do_color (int, int, int, NCURSES_OUTC);
 extern NCURSES_EXPORT(void) _nc_flush (void);
@@ -2330,6 +2423,18 @@ extern NCURSES_EXPORT(void) _nc_resize_margins (WINDOW *);
 #define _nc_resize_margins(wp) /* nothing */
 #endif
 
+#if NCURSES_EXT_FUNCS
+extern NCURSES_EXPORT(void) _nc_free_user_fds (SCREEN *);
+extern NCURSES_EXPORT(void) _nc_user_fd_dispatch (SCREEN *);
+extern NCURSES_EXPORT(int) _nc_fifo_read (SCREEN *, char *, size_t);
+#if USE_WIDEC_SUPPORT
+extern NCURSES_EXPORT(int) _nc_fifo_utf8 (SCREEN *, wint_t *, int);
+#endif
+#define HasUserFds(sp) ((sp)->_user_fd_count != 0)
+#else
+#define HasUserFds(sp) FALSE
+#endif
+
 #ifdef NCURSES_WGETCH_EVENTS
 extern NCURSES_EXPORT(int) _nc_eventlist_timeout(_nc_eventlist *);
 #else
@@ -2458,6 +2563,7 @@ extern NCURSES_EXPORT(int) _nc_get_tty_mode(TTY *);
 #define TW_MOUSE   2
 #define TW_ANY     (TW_INPUT | TW_MOUSE)
 #define TW_EVENT   4
+#define TW_USER    8	/* descriptors registered with register_fd() */
 
 #define SetSafeOutcWrapper(outc)	    \
     SCREEN* sp = CURRENT_SCREEN;            \
@@ -214,6 +214,11 @@ NCURSES_EXPORT(const HashData *) _nc_get_hash_info (bool termcap)
     return &hash_data[(termcap != FALSE)];
 }
 
+NCURSES_EXPORT(const PerfectData *) _nc_get_perfect_info (bool termcap)
+{
+    return termcap ? &_nc_cap_perfect_data : &_nc_info_perfect_data;
+}
+
 #if NO_LEAKS
 NCURSES_EXPORT(void) _nc_comp_captab_leaks(void)
 {
@@ -130,6 +130,11 @@ NCURSES_EXPORT(const HashData *) _nc_get_hash_user (void)
     return hash_data;
 }
 
+NCURSES_EXPORT(const PerfectData *) _nc_get_perfect_user (void)
+{
+    return &_nc_user_perfect_data;
+}
+
 #if NO_LEAKS
 NCURSES_EXPORT(void) _nc_comp_userdefs_leaks(void)
 {
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2016,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -47,6 +47,13 @@ NCURSES_EXPORT_VAR(bool) _nc_suppress_warnings = FALSE;
 NCURSES_EXPORT_VAR(int) _nc_curr_line = 0; /* current line # in input */
 NCURSES_EXPORT_VAR(int) _nc_curr_col = 0; /* current column # in input */
 
+/*
+ * If set, this is called rather than exiting on a fatal error.  It must not
+ * return, e.g., it may longjmp back to a caller which can discard the work.
+ * Such a caller may suppress the error messages with the warnings.
+ */
+NCURSES_IMPEXP void NCURSES_API(*_nc_err_recovery) (void) = 0;
+
 #define SourceName	_nc_globals.comp_sourcename
 #define TermType	_nc_globals.comp_termtype
 
@@ -119,16 +126,22 @@ _nc_warning(const char *const fmt, ...)
     va_end(argp);
 }
 
+#define SilentAbort() (_nc_err_recovery != 0 && _nc_suppress_warnings)
+
 NCURSES_EXPORT(void)
 _nc_err_abort(const char *const fmt, ...)
 {
     va_list argp;
 
-    where_is_problem();
-    va_start(argp, fmt);
-    vfprintf(stderr, fmt, argp);
-    fprintf(stderr, "\n");
-    va_end(argp);
+    if (!SilentAbort()) {
+	where_is_problem();
+	va_start(argp, fmt);
+	vfprintf(stderr, fmt, argp);
+	fprintf(stderr, "\n");
+	va_end(argp);
+    }
+    if (_nc_err_recovery != 0)
+	(*_nc_err_recovery) ();
     exit(EXIT_FAILURE);
 }
 
@@ -137,11 +150,15 @@ _nc_syserr_abort(const char *const fmt, ...)
 {
     va_list argp;
 
-    where_is_problem();
-    va_start(argp, fmt);
-    vfprintf(stderr, fmt, argp);
-    fprintf(stderr, "\n");
-    va_end(argp);
+    if (!SilentAbort()) {
+	where_is_problem();
+	va_start(argp, fmt);
+	vfprintf(stderr, fmt, argp);
+	fprintf(stderr, "\n");
+	va_end(argp);
+    }
+    if (_nc_err_recovery != 0)
+	(*_nc_err_recovery) ();
 
 #if defined(TRACE) || !defined(NDEBUG)
     /* If we're debugging, try to show where the problem occurred - this
@@ -46,6 +46,43 @@
 
 MODULE_ID("$Id: comp_hash.c,v 1.51 2019/10/12 16:32:13 tom Exp $")
 
+/*
+ *	unsigned perfect_hash(string, seed, limit)
+ *
+ *	Computes the seeded hash used for the perfect-hash tables.  This must
+ *	match the function in make_hash.c.  If limit is nonzero, only that many
+ *	characters of the string are used.
+ */
+static unsigned
+perfect_hash(const char *string, unsigned seed, unsigned limit)
+{
+    unsigned long result = (2166136261UL ^ (seed * 2654435769UL)) & 0xffffffffUL;
+    unsigned used = 0;
+
+    while (*string != '\0' && (limit == 0 || used++ < limit)) {
+	result ^= UChar(*string++);
+	result = (result * 16777619UL) & 0xffffffffUL;
+    }
+    result ^= (result >> 15);
+    result = (result * 0x2c1b3c6dUL) & 0xffffffffUL;
+    result ^= (result >> 12);
+    return (unsigned) result;
+}
+
+/*
+ * Returns the index of the only table entry which may match the given string,
+ * or -1.  The caller must compare the names.
+ */
+static int
+perfect_index(const PerfectData * data, const char *string)
+{
+    unsigned bucket = perfect_hash(string, 0, data->limit) % data->buckets;
+    unsigned slot = (perfect_hash(string, data->seeds[bucket], data->limit)
+		     % data->slots);
+
+    return data->entries[slot];
+}
+
 /*
  * Finds the entry for the given string in the hash table if present.
  * Returns a pointer to the entry in the table or 0 if not found.
@@ -57,26 +94,13 @@ _nc_find_entry(const char *string,
 {
     bool termcap = (hash_table != _nc_get_hash_table(FALSE));
     const HashData *data = _nc_get_hash_info(termcap);
-    int hashvalue;
+    int n = perfect_index(_nc_get_perfect_info(termcap), string);
     struct name_table_entry const *ptr = 0;
-    struct name_table_entry const *real_table;
 
-    hashvalue = data->hash_of(string);
-
-    if (hashvalue >= 0
-	&& (unsigned) hashvalue < data->table_size
-	&& data->table_data[hashvalue] >= 0) {
-
-	real_table = _nc_get_table(termcap);
-	ptr = real_table + data->table_data[hashvalue];
-	while (!data->compare_names(ptr->nte_name, string)) {
-	    if (ptr->nte_link < 0) {
-		ptr = 0;
-		break;
-	    }
-	    ptr = real_table + (ptr->nte_link
-				+ data->table_data[data->table_size]);
-	}
+    if (n >= 0) {
+	ptr = _nc_get_table(termcap) + n;
+	if (!data->compare_names(ptr->nte_name, string))
+	    ptr = 0;
     }
 
     return (ptr);
@@ -85,7 +109,8 @@ _nc_find_entry(const char *string,
 /*
  * Finds the entry for the given name with the given type in the given table if
  * present (as distinct from _nc_find_entry, which finds the last entry
- * regardless of type).
+ * regardless of type).  The perfect hash gives the last entry for the name;
+ * any others are further along its chain in the hash table.
  *
  * Returns a pointer to the entry in the table or 0 if not found.
  */
@@ -96,21 +121,23 @@ _nc_find_type_entry(const char *string,
 {
     struct name_table_entry const *ptr = NULL;
     const HashData *data = _nc_get_hash_info(termcap);
-    int hashvalue = data->hash_of(string);
+    int n = perfect_index(_nc_get_perfect_info(termcap), string);
 
-    if (hashvalue >= 0
-	&& (unsigned) hashvalue < data->table_size
-	&& data->table_data[hashvalue] >= 0) {
+    if (n >= 0) {
 	const struct name_table_entry *const table = _nc_get_table(termcap);
 
-	ptr = table + data->table_data[hashvalue];
-	while (ptr->nte_type != type
-	       || !data->compare_names(ptr->nte_name, string)) {
-	    if (ptr->nte_link < 0) {
-		ptr = 0;
-		break;
+	ptr = table + n;
+	if (!data->compare_names(ptr->nte_name, string)) {
+	    ptr = 0;
+	} else {
+	    while (ptr->nte_type != type
+		   || !data->compare_names(ptr->nte_name, string)) {
+		if (ptr->nte_link < 0) {
+		    ptr = 0;
+		    break;
+		}
+		ptr = table + (ptr->nte_link + data->table_data[data->table_size]);
 	    }
-	    ptr = table + (ptr->nte_link + data->table_data[data->table_size]);
 	}
     }
 
@@ -122,26 +149,13 @@ NCURSES_EXPORT(struct user_table_entry const *)
 _nc_find_user_entry(const char *string)
 {
     const HashData *data = _nc_get_hash_user();
-    int hashvalue;
+    int n = perfect_index(_nc_get_perfect_user(), string);
     struct user_table_entry const *ptr = 0;
-    struct user_table_entry const *real_table;
-
-    hashvalue = data->hash_of(string);
-
-    if (hashvalue >= 0
-	&& (unsigned) hashvalue < data->table_size
-	&& data->table_data[hashvalue] >= 0) {
 
-	real_table = _nc_get_userdefs_table();
-	ptr = real_table + data->table_data[hashvalue];
-	while (!data->compare_names(ptr->ute_name, string)) {
-	    if (ptr->ute_link < 0) {
-		ptr = 0;
-		break;
-	    }
-	    ptr = real_table + (ptr->ute_link
-				+ data->table_data[data->table_size]);
-	}
+    if (n >= 0) {
+	ptr = _nc_get_userdefs_table() + n;
+	if (!data->compare_names(ptr->ute_name, string))
+	    ptr = 0;
     }
 
     return (ptr);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -206,23 +206,27 @@ _nc_entry_match(char *n1, char *n2)
  *
  ****************************************************************************/
 
-NCURSES_EXPORT(void)
-_nc_read_entry_source(FILE *fp, char *buf,
-		      int literal, bool silent,
-		      bool(*hook) (ENTRY *))
-/* slurp all entries in the given file into core */
+static ENTRY thisentry;		/* the entry being read */
+static bool parsing;		/* its strings are not yet wrapped */
+
+static void
+read_entries(int literal, bool silent, bool(*hook) (ENTRY *))
+/* slurp all entries from the scanner's input into core */
 {
-    ENTRY thisentry;
     bool oldsuppress = _nc_suppress_warnings;
     int immediate = 0;
 
     if (silent)
 	_nc_suppress_warnings = TRUE;	/* shut the lexer up, too */
 
-    _nc_reset_input(fp, buf);
     for (;;) {
+	int status;
+
 	memset(&thisentry, 0, sizeof(thisentry));
-	if (_nc_parse_entry(&thisentry, literal, silent) == ERR)
+	parsing = TRUE;
+	status = _nc_parse_entry(&thisentry, literal, silent);
+	parsing = FALSE;
+	if (status == ERR)
 	    break;
 	if (!isalnum(UChar(thisentry.tterm.term_names[0])))
 	    _nc_err_abort("terminal names must start with letter or digit");
@@ -248,6 +252,7 @@ _nc_read_entry_source(FILE *fp, char *buf,
 #endif
 	}
     }
+    memset(&thisentry, 0, sizeof(thisentry));
 
     if (_nc_tail) {
 	/* set up the head pointer */
@@ -265,6 +270,26 @@ _nc_read_entry_source(FILE *fp, char *buf,
     _nc_suppress_warnings = oldsuppress;
 }
 
+NCURSES_EXPORT(void)
+_nc_read_entry_source(FILE *fp, char *buf,
+		      int literal, bool silent,
+		      bool(*hook) (ENTRY *))
+/* slurp all entries in the given file into core */
+{
+    _nc_reset_input(fp, buf);
+    read_entries(literal, silent, hook);
+}
+
+NCURSES_EXPORT(void)
+_nc_read_entry_buffer(const char *source, size_t length,
+		      int literal, bool silent,
+		      bool(*hook) (ENTRY *))
+/* slurp all entries in the given text into core */
+{
+    _nc_reset_source(source, length);
+    read_entries(literal, silent, hook);
+}
+
 #if NCURSES_XNAMES
 static unsigned
 find_capname(TERMTYPE2 *p, const char *name)
@@ -385,29 +410,240 @@ invalid_merge(TERMTYPE2 *to, TERMTYPE2 *from)
 #define validate_merge(p, q)	/* nothing */
 #endif
 
+/*
+ * Index the names of the in-core entries, so that checking for collisions and
+ * resolving "use=" references need not compare every pair of entries.  Each
+ * field of the names (aliases and description) is hashed.  A lookup yields
+ * candidates, which are checked against the current names, since
+ * remove_collision() may have edited those since the index was built.
+ */
+typedef struct {
+    NAME_NODE **table;
+    NAME_NODE *nodes;
+    ENTRY **entries;		/* the entries, in list order */
+    unsigned *found;		/* scratch array for find_collisions() */
+    unsigned size;		/* number of hash-chains, a power of two */
+    unsigned count;		/* number of entries */
+} NAME_INDEX;
+
+static NAME_INDEX name_index;	/* in use by _nc_resolve_uses2() */
+
+/*
+ * Hash a field of a list of names (FNV-1a).
+ */
+NCURSES_EXPORT(unsigned)
+_nc_hash_name(const char *name, size_t length)
+{
+    unsigned result = 2166136261U;
+
+    while (length-- != 0) {
+	result ^= UChar(*name++);
+	result *= 16777619U;
+    }
+    return result;
+}
+
+/*
+ * Return the length of the first field of a list of names.
+ */
+NCURSES_EXPORT(size_t)
+_nc_field_length(const char *name)
+{
+    const char *end = strchr(name, '|');
+    return (end != 0) ? (size_t) (end - name) : strlen(name);
+}
+
+/*
+ * Compare positions of entries, for qsort.
+ */
+NCURSES_EXPORT(int)
+_nc_compare_order(const void *a, const void *b)
+{
+    unsigned p = *(const unsigned *) a;
+    unsigned q = *(const unsigned *) b;
+    return (p > q) - (p < q);
+}
+
+/*
+ * Add a node for each field of an entry's names to the front of the table's
+ * hash-chains, given the size of the table (a power of two).  Return the
+ * number of nodes used.
+ */
+NCURSES_EXPORT(unsigned)
+_nc_index_fields(NAME_NODE ** table,
+		 unsigned size,
+		 NAME_NODE * nodes,
+		 const char *name,
+		 unsigned order)
+{
+    unsigned used = 0;
+
+    for (;;) {
+	size_t length = _nc_field_length(name);
+	NAME_NODE *node = &nodes[used++];
+	unsigned bucket;
+
+	node->hashed = _nc_hash_name(name, length);
+	node->order = order;
+	bucket = node->hashed & (size - 1);
+	node->next = table[bucket];
+	table[bucket] = node;
+	if (name[length] == '\0')
+	    break;
+	name += length + 1;
+    }
+    return used;
+}
+
+static void
+index_names(NAME_INDEX * ix)
+{
+    ENTRY *qp;
+    unsigned fields = 0;
+    unsigned used = 0;
+    unsigned n;
+
+    memset(ix, 0, sizeof(*ix));
+    for_entry_list(qp) {
+	const char *s;
+
+	++(ix->count);
+	++fields;
+	for (s = qp->tterm.term_names; *s != '\0'; ++s) {
+	    if (*s == '|')
+		++fields;
+	}
+    }
+    if (ix->count == 0)
+	return;
+
+    for (ix->size = 64; ix->size < 2 * fields; ix->size <<= 1) {
+	;
+    }
+    ix->table = typeCalloc(NAME_NODE *, ix->size);
+    ix->nodes = typeMalloc(NAME_NODE, fields);
+    ix->entries = typeMalloc(ENTRY *, ix->count);
+    ix->found = typeCalloc(unsigned, ix->count);
+    if (ix->table == 0 || ix->nodes == 0 || ix->entries == 0 || ix->found == 0)
+	_nc_err_abort(MSG_NO_MEMORY);
+
+    n = 0;
+    for_entry_list(qp) {
+	ix->entries[n++] = qp;
+    }
+
+    /* adding the entries in reverse leaves each chain in list order */
+    for (n = ix->count; n-- != 0;) {
+	used += _nc_index_fields(ix->table, ix->size, ix->nodes + used,
+				 ix->entries[n]->tterm.term_names, n);
+    }
+    DEBUG(2, ("indexed %u names of %u entries", used, ix->count));
+}
+
+static void
+free_index(NAME_INDEX * ix)
+{
+    FreeIfNeeded(ix->table);
+    FreeIfNeeded(ix->nodes);
+    FreeIfNeeded(ix->entries);
+    FreeIfNeeded(ix->found);
+    memset(ix, 0, sizeof(*ix));
+}
+
+/*
+ * Store in ix->found the positions of the entries before the given one which
+ * may share a name with it, in list order.  Return the number found.
+ */
+static unsigned
+find_collisions(NAME_INDEX * ix, unsigned order)
+{
+    const char *name = ix->entries[order]->tterm.term_names;
+    unsigned result = 0;
+
+    for (;;) {
+	size_t length = _nc_field_length(name);
+	unsigned hashed = _nc_hash_name(name, length);
+	NAME_NODE *node;
+
+	for (node = ix->table[hashed & (ix->size - 1)];
+	     node != 0 && node->order < order;
+	     node = node->next) {
+	    if (node->hashed == hashed) {
+		unsigned k;
+
+		for (k = 0; k < result; ++k) {
+		    if (ix->found[k] == node->order)
+			break;
+		}
+		if (k == result)
+		    ix->found[result++] = node->order;
+	    }
+	}
+	if (name[length] == '\0')
+	    break;
+	name += length + 1;
+    }
+    if (result > 1)
+	qsort(ix->found, (size_t) result, sizeof(unsigned), _nc_compare_order);
+    return result;
+}
+
+/*
+ * Return the last entry other than the given one which has the name, or null.
+ */
+static ENTRY *
+find_use(NAME_INDEX * ix, ENTRY * qp, const char *lookfor)
+{
+    ENTRY *result = 0;
+
+    if (ix->count != 0) {
+	unsigned hashed = _nc_hash_name(lookfor, strlen(lookfor));
+	NAME_NODE *node;
+
+	for (node = ix->table[hashed & (ix->size - 1)];
+	     node != 0;
+	     node = node->next) {
+	    ENTRY *rp = ix->entries[node->order];
+
+	    if (node->hashed == hashed
+		&& rp != qp
+		&& _nc_name_match(rp->tterm.term_names, lookfor, "|")) {
+		result = rp;
+	    }
+	}
+    }
+    return result;
+}
+
 NCURSES_EXPORT(int)
 _nc_resolve_uses2(bool fullresolve, bool literal)
 /* try to resolve all use capabilities */
 {
     ENTRY *qp, *rp, *lastread = 0;
+    NAME_INDEX *names = &name_index;
     bool keepgoing;
     unsigned i;
     int unresolved, total_unresolved, multiples;
 
     DEBUG(2, ("RESOLUTION BEGINNING"));
 
+    index_names(names);
+
     /*
      * Check for multiple occurrences of the same name.
      */
     multiples = 0;
-    for_entry_list(qp) {
+    for (i = 0; i < names->count; ++i) {
+	unsigned found = find_collisions(names, i);
+	unsigned k;
 	int matchcount = 0;
 
-	for_entry_list(rp) {
-	    if (qp > rp
-		&& check_collisions(qp->tterm.term_names,
-				    rp->tterm.term_names,
-				    matchcount + 1)) {
+	qp = names->entries[i];
+	for (k = 0; k < found; ++k) {
+	    rp = names->entries[names->found[k]];
+	    if (check_collisions(qp->tterm.term_names,
+				 rp->tterm.term_names,
+				 matchcount + 1)) {
 		if (!matchcount++) {
 		    (void) fprintf(stderr, "\t%s\n", rp->tterm.term_names);
 		}
@@ -419,8 +655,10 @@ _nc_resolve_uses2(bool fullresolve, bool literal)
 	    }
 	}
     }
-    if (multiples > 0)
+    if (multiples > 0) {
+	free_index(names);
 	return (FALSE);
+    }
 
     DEBUG(2, ("NO MULTIPLE NAME OCCURRENCES"));
 
@@ -445,15 +683,12 @@ _nc_resolve_uses2(bool fullresolve, bool literal)
 	    _nc_set_type(child);
 
 	    /* first, try to resolve from in-core records */
-	    for_entry_list(rp) {
-		if (rp != qp
-		    && _nc_name_match(rp->tterm.term_names, lookfor, "|")) {
-		    DEBUG(2, ("%s: resolving use=%s (in core)",
-			      child, lookfor));
+	    if ((rp = find_use(names, qp, lookfor)) != 0) {
+		DEBUG(2, ("%s: resolving use=%s (in core)",
+			  child, lookfor));
 
-		    qp->uses[i].link = rp;
-		    foundit = TRUE;
-		}
+		qp->uses[i].link = rp;
+		foundit = TRUE;
 	    }
 
 	    /* if that didn't work, try to merge in a compiled entry */
@@ -488,6 +723,7 @@ _nc_resolve_uses2(bool fullresolve, bool literal)
 	    }
 	}
     }
+    free_index(names);
     if (total_unresolved) {
 	/* free entries read in off disk */
 	_nc_free_entries(lastread);
@@ -612,6 +848,7 @@ _nc_resolve_uses2(bool fullresolve, bool literal)
 		set_curterm(&fake_tm);
 
 		_nc_check_termtype2(&qp->tterm, literal);
+		_nc_free_ext_index(&fake_tm);
 
 		_nc_set_screen(save_SP);
 		set_curterm(save_tm);
@@ -625,6 +862,36 @@ _nc_resolve_uses2(bool fullresolve, bool literal)
     return (TRUE);
 }
 
+/*
+ * Discard the entries which have been read and the index used to resolve
+ * them, e.g., when a caller recovers from a fatal error which interrupted
+ * reading or resolving entries.
+ */
+NCURSES_EXPORT(void)
+_nc_discard_entries(void)
+{
+    T((T_CALLED("_nc_discard_entries()")));
+
+    /* until _nc_parse_entry() wraps it, the string table is not allocated */
+    if (parsing) {
+	thisentry.tterm.str_table = 0;
+	parsing = FALSE;
+    }
+    _nc_free_termtype2(&thisentry.tterm);
+    memset(&thisentry, 0, sizeof(thisentry));
+    free_index(&name_index);
+
+    /* read_entries() sets _nc_head only when it finishes */
+    if (_nc_tail != 0) {
+	for (_nc_head = _nc_tail; _nc_head->last; _nc_head = _nc_head->last)
+	    continue;
+    }
+    _nc_free_entries(_nc_head);
+    _nc_head = 0;
+    _nc_tail = 0;
+    returnVoid;
+}
+
 /*
  * This bit of legerdemain turns all the terminfo variable names into
  * references to locations in the arrays Booleans, Numbers, and Strings ---
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2016,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -36,6 +36,7 @@
  *	comp_scan.c --- Lexical scanner for terminfo compiler.
  *
  *	_nc_reset_input()
+ *	_nc_reset_source()
  *	_nc_get_token()
  *	_nc_panic_mode()
  *	int _nc_syntax;
@@ -100,6 +101,58 @@ static char *bufptr;		/* otherwise, the input buffer pointer */
 static char *bufstart;		/* start of buffer so we can compute offsets */
 static FILE *yyin;		/* scanner's input file descriptor */
 
+/*
+ * A regular file is read into memory in one piece, and next_char() takes
+ * its lines from that copy rather than calling fgets() for each line.  The
+ * offsets derived from srcnext are the same as ftell() would give.  A source
+ * given by _nc_reset_source() is scanned the same way, with no file.
+ */
+static char *srcbuf;		/* contents of yyin, from srcbase to the end */
+static char *srcnext;		/* the next line to be scanned */
+static char *srcend;		/* the end of the contents */
+static long srcbase;		/* file-offset of srcbuf */
+static bool srceof;		/* feof() of yyin, as seen through srcbuf */
+
+static void
+free_source(void)
+{
+    FreeIfNeeded(srcbuf);
+    srcbuf = srcnext = srcend = 0;
+    srcbase = 0;
+    srceof = FALSE;
+}
+
+static void
+load_source(FILE *fp)
+{
+    struct stat sb;
+    long offset;
+
+    free_source();
+    if (fstat(fileno(fp), &sb) == 0
+	&& S_ISREG(sb.st_mode)
+	&& (offset = ftell(fp)) >= 0
+	&& (long) sb.st_size > offset) {
+	size_t want = (size_t) ((long) sb.st_size - offset);
+	size_t have;
+
+	if ((srcbuf = typeMalloc(char, want + 1)) != 0) {
+	    have = fread(srcbuf, sizeof(char), want, fp);
+	    if (have == 0 || ferror(fp)) {
+		/* let the stdio-based scanner deal with it */
+		free_source();
+		clearerr(fp);
+		(void) fseek(fp, offset, SEEK_SET);
+	    } else {
+		srcbuf[have] = '\0';
+		srcnext = srcbuf;
+		srcend = srcbuf + have;
+		srcbase = offset;
+	    }
+	}
+    }
+}
+
 /*
  *	_nc_reset_input()
  *
@@ -115,6 +168,10 @@ _nc_reset_input(FILE *fp, char *buf)
     if (pushname != 0)
 	pushname[0] = '\0';
     yyin = fp;
+    if (fp != 0)
+	load_source(fp);
+    else
+	free_source();
     bufstart = bufptr = buf;
     _nc_curr_file_pos = 0L;
     if (fp != 0)
@@ -122,6 +179,33 @@ _nc_reset_input(FILE *fp, char *buf)
     _nc_curr_col = 0;
 }
 
+/*
+ *	_nc_reset_source()
+ *
+ *	Resets the input-reading routines to scan a copy of the given text,
+ *	which may contain any number of entries, as if it were read from a file.
+ */
+
+NCURSES_EXPORT(void)
+_nc_reset_source(const char *source, size_t length)
+{
+    pushtype = NO_PUSHBACK;
+    if (pushname != 0)
+	pushname[0] = '\0';
+    yyin = 0;
+    free_source();
+    if ((srcbuf = typeMalloc(char, length + 1)) != 0) {
+	memcpy(srcbuf, source, length);
+	srcbuf[length] = '\0';
+	srcnext = srcbuf;
+	srcend = srcbuf + length;
+    }
+    bufstart = bufptr = 0;
+    _nc_curr_file_pos = 0L;
+    _nc_curr_line = 0;
+    _nc_curr_col = 0;
+}
+
 /*
  *	int last_char()
  *
@@ -143,6 +227,39 @@ last_char(int from_end)
     return result;
 }
 
+/*
+ * Skip the indentation of a newly-read line of the given length, and
+ * normalize a trailing <cr><lf>.  Returns the length of the remainder of the
+ * line.
+ */
+static size_t
+begin_line(size_t len)
+{
+    while (iswhite(*bufptr)) {
+	if (*bufptr == '\t') {
+	    _nc_curr_col = (_nc_curr_col | 7) + 1;
+	} else {
+	    _nc_curr_col++;
+	}
+	bufptr++;
+	len--;
+    }
+
+    /*
+     * Treat a trailing <cr><lf> the same as a <newline> so we can read files
+     * on OS/2, etc.
+     */
+    if (len > 1) {
+	if (bufptr[len - 1] == '\n'
+	    && bufptr[len - 2] == '\r') {
+	    len--;
+	    bufptr[len - 1] = '\n';
+	    bufptr[len] = '\0';
+	}
+    }
+    return len;
+}
+
 /*
  *	int next_char()
  *
@@ -164,7 +281,7 @@ next_char(void)
     static size_t allocated;
     int the_char;
 
-    if (!yyin) {
+    if (!yyin && srcbuf == 0) {
 	if (result != 0) {
 	    FreeAndNull(result);
 	    FreeAndNull(pushname);
@@ -184,6 +301,55 @@ next_char(void)
 	} else if (*bufptr == '\t') {
 	    _nc_curr_col = (_nc_curr_col | 7);
 	}
+    } else if ((!bufptr || !*bufptr) && srcbuf != 0) {
+	size_t len;
+	char *eol;
+
+	if (_nc_curr_line == 0 && IS_TIC_MAGIC(srcnext)) {
+	    _nc_err_abort("This is a compiled terminal description, not a source");
+	}
+
+	/* find the next line which is not a comment, without copying */
+	for (;;) {
+	    if (srcnext >= srcend) {
+		srceof = TRUE;
+		bufptr = bufstart = 0;
+		return (EOF);
+	    }
+	    _nc_curr_file_pos = srcbase + (long) (srcnext - srcbuf);
+	    _nc_curr_line++;
+	    _nc_curr_col = 0;
+	    len = (size_t) (srcend - srcnext);
+	    if ((eol = memchr(srcnext, '\n', len)) != 0) {
+		len = (size_t) (eol + 1 - srcnext);
+	    } else {
+		srceof = TRUE;
+	    }
+	    if (*srcnext != '#')
+		break;
+	    srcnext += len;
+	}
+
+	/* push_back() and begin_line() modify the line, so copy it */
+	if (len + 2 > allocated) {
+	    allocated = len + LEXBUFSIZ;
+	    result = typeRealloc(char, allocated, result);
+	    if (result == 0)
+		return (EOF);
+	}
+	memcpy(result, srcnext, len);
+	srcnext += len;
+	result[len] = '\0';
+	if (result[len - 1] != '\n') {
+	    len = strlen(result);
+	    result[len++] = '\n';
+	    result[len] = '\0';
+	}
+
+	bufstart = bufptr = result;
+	if (*bufptr == '\0')
+	    return (EOF);
+	(void) begin_line(len);
     } else if (!bufptr || !*bufptr) {
 	/*
 	 * In theory this could be recoded to do its I/O one character at a
@@ -226,27 +392,7 @@ next_char(void)
 		    used = strlen(bufptr);
 		    if (used == 0)
 			return (EOF);
-		    while (iswhite(*bufptr)) {
-			if (*bufptr == '\t') {
-			    _nc_curr_col = (_nc_curr_col | 7) + 1;
-			} else {
-			    _nc_curr_col++;
-			}
-			bufptr++;
-		    }
-
-		    /*
-		     * Treat a trailing <cr><lf> the same as a <newline> so we
-		     * can read files on OS/2, etc.
-		     */
-		    if ((len = strlen(bufptr)) > 1) {
-			if (bufptr[len - 1] == '\n'
-			    && bufptr[len - 2] == '\r') {
-			    len--;
-			    bufptr[len - 1] = '\n';
-			    bufptr[len] = '\0';
-			}
-		    }
+		    len = begin_line(used);
 		} else {
 		    return (EOF);
 		}
@@ -279,17 +425,100 @@ static long
 stream_pos(void)
 /* return our current character position in the input stream */
 {
-    return (yyin ? ftell(yyin) : (bufptr ? bufptr - bufstart : 0));
+    return (srcbuf
+	    ? srcbase + (long) (srcnext - srcbuf)
+	    : (yyin
+	       ? ftell(yyin)
+	       : (bufptr ? bufptr - bufstart : 0)));
 }
 
 static bool
 end_of_stream(void)
 /* are we at end of input? */
 {
-    return ((yyin ? feof(yyin) : (bufptr && *bufptr == '\0'))
+    return ((srcbuf
+	     ? srceof
+	     : (yyin
+		? feof(yyin)
+		: (bufptr && *bufptr == '\0')))
 	    ? TRUE : FALSE);
 }
 
+/*
+ * The scanner's inner loops take runs of ordinary characters directly from
+ * the current line rather than through next_char().  A run never includes a
+ * tab, newline or null, so consuming it only advances the column.
+ */
+static NCURSES_INLINE void
+skip_chars(size_t count)
+{
+    if (count != 0) {
+	bufptr += count;
+	_nc_curr_col += (int) count;
+	first_column = FALSE;
+    }
+}
+
+/*
+ * Returns the length (up to limit) of the run of characters at the current
+ * position which may be part of a capability name.
+ */
+static size_t
+name_span(size_t limit)
+{
+    char *s = bufptr;
+    char *last;
+    int extra = (_nc_syntax == SYN_TERMINFO) ? '_' : ';';
+
+    if (s == 0)
+	return 0;
+    for (last = s + limit; s < last; ++s) {
+	if (!isalnum(UChar(*s)) && *s != extra)
+	    break;
+    }
+    return (size_t) (s - bufptr);
+}
+
+/*
+ * Returns the length (up to limit) of the run of characters at the current
+ * position which may be part of a number.
+ */
+static size_t
+number_span(size_t limit)
+{
+    char *s = bufptr;
+    char *last;
+
+    if (s == 0)
+	return 0;
+    for (last = s + limit; s < last && isalnum(UChar(*s)); ++s) {
+	;
+    }
+    return (size_t) (s - bufptr);
+}
+
+/*
+ * Returns the length (up to limit) of the run of characters at the current
+ * position which _nc_trans_string() copies without translation.
+ */
+static size_t
+string_span(size_t limit)
+{
+    char stops[8];
+    size_t result;
+
+    if (bufptr == 0)
+	return 0;
+    stops[0] = '^';
+    stops[1] = '\\';
+    stops[2] = '\n';
+    stops[3] = '\t';
+    stops[4] = separator;
+    stops[5] = '\0';
+    result = strcspn(bufptr, stops);
+    return (result < limit) ? result : limit;
+}
+
 /* Assume we may be looking at a termcap-style continuation */
 static NCURSES_INLINE int
 eat_escaped_newline(int ch)
@@ -383,6 +612,7 @@ _nc_get_token(bool silent)
 
     if (end_of_stream()) {
 	yyin = 0;
+	free_source();
 	(void) next_char();	/* frees its allocated memory */
 	if (tok_buf != 0) {
 	    if (_nc_curr_token.tk_name == tok_buf)
@@ -624,7 +854,18 @@ _nc_get_token(bool silent)
 		_nc_warning("Missing backslash before newline");
 		had_newline = FALSE;
 	    }
-	    while ((ch = next_char()) != EOF) {
+	    for (;;) {
+		size_t run = name_span((size_t) (TOK_BUF_SIZE - 2
+						 - (tok_ptr - tok_buf)));
+
+		if (run != 0) {
+		    memcpy(tok_ptr, bufptr, run);
+		    tok_ptr += run;
+		    *tok_ptr = '\0';
+		    skip_chars(run);
+		}
+		if ((ch = next_char()) == EOF)
+		    break;
 		if (!isalnum(UChar(ch))) {
 		    if (_nc_syntax == SYN_TERMINFO) {
 			if (ch != '_')
@@ -660,7 +901,9 @@ _nc_get_token(bool silent)
 		break;
 
 	    case '#':
-		found = 0;
+		found = (unsigned) number_span(sizeof(numbuf) - 2);
+		memcpy(numbuf, bufptr, found);
+		skip_chars(found);
 		while (isalnum(ch = next_char())) {
 		    numbuf[found++] = (char) ch;
 		    if (found >= sizeof(numbuf) - 1)
@@ -956,6 +1199,30 @@ _nc_trans_string(char *ptr, char *last)
 	    _nc_warning("Very long string found.  Missing separator?");
 	    long_warning = TRUE;
 	}
+
+	/*
+	 * Copy the ordinary characters which follow, stopping where the loop
+	 * would first do something other than copy them: at the end of the
+	 * buffer, or where the long-string warning would be issued.
+	 */
+	if (_nc_curr_col >= 1 && ptr < (last - 1)) {
+	    size_t limit = (size_t) ((last - 1) - ptr);
+	    size_t run;
+
+	    if (!long_warning && (size_t) (MAXCAPLEN + 1 - count) < limit)
+		limit = (size_t) (MAXCAPLEN + 1 - count);
+	    if ((run = string_span(limit)) != 0) {
+		memcpy(ptr, bufptr, run);
+		ptr += run;
+		count += (int) run;
+		last_ch = UChar(bufptr[run - 1]);
+		skip_chars(run);
+		if (count > MAXCAPLEN && !long_warning) {
+		    _nc_warning("Very long string found.  Missing separator?");
+		    long_warning = TRUE;
+		}
+	    }
+	}
     }				/* end while */
 
     *ptr = '\0';
@@ -1016,5 +1283,6 @@ _nc_comp_scan_leaks(void)
     if (tok_buf != 0) {
 	FreeAndNull(tok_buf);
     }
+    free_source();
 }
 #endif
@@ -0,0 +1,277 @@
+/****************************************************************************
+ * Copyright (c) 2020 Free Software Foundation, Inc.                        *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/*
+ *	comp_source.c -- compile terminfo source held in memory
+ *
+ *	_nc_compile_source(source, length, flags)
+ *	_nc_compiled_count(compiled)
+ *	_nc_compiled_entry(compiled, n)
+ *	_nc_compiled_find(compiled, name)
+ *	_nc_compiled_image(compiled, n, buffer, length, limit)
+ *	_nc_free_compiled(compiled)
+ *
+ *	These let an application compile terminal descriptions which it
+ *	carries with it, without running tic.  The entries are parsed and
+ *	their use= clauses resolved as tic would do, but into a list owned by
+ *	the caller rather than _nc_head/_nc_tail, and nothing is written to
+ *	the filesystem.  Callers may then use the resolved TERMTYPE2 data
+ *	directly, or ask for the compiled form of an entry, which is what tic
+ *	would write to the terminfo database.
+ *
+ *	The parser keeps its state in static variables.  Calls are serialized
+ *	with the global curses lock, which does nothing unless the library is
+ *	configured for threads; otherwise the caller must not call these
+ *	functions concurrently, e.g., from a signal handler.
+ *
+ *	Errors which would make tic exit make _nc_compile_source() return null
+ *	instead, after discarding the entries read so far and resetting the
+ *	scanner.  With TIC_SILENT, those errors are not reported.
+ */
+
+#include <curses.priv.h>
+
+#include <tic.h>
+#include <setjmp.h>
+
+MODULE_ID("$Id: comp_source.c,v 1.1 2020/01/25 00:00:00 tom Exp $")
+
+struct tic_compiled {
+    ENTRY *head;		/* list of resolved entries */
+    ENTRY *tail;
+    int count;			/* number of entries in the list */
+    ENTRY **index;		/* the same entries, in order */
+};
+
+static jmp_buf recovery;
+
+static void
+recover(void)
+{
+    longjmp(recovery, 1);
+}
+
+/*
+ * Free a list of entries using _nc_free_entries(), which works on _nc_head.
+ * The caller has saved the global list.
+ */
+static void
+free_list(ENTRY * head, ENTRY * tail)
+{
+    _nc_head = head;
+    _nc_tail = tail;
+    _nc_free_entries(_nc_head);
+}
+
+/*
+ * Parse and resolve the entries in the source, leaving them in _nc_head.
+ * If that succeeds, move the list to the result.
+ */
+static void
+compile_entries(TIC_COMPILED * result, const char *source, size_t length, int flags)
+{
+    bool literal = (flags & TIC_LITERAL) != 0;
+    bool silent = (flags & TIC_SILENT) != 0;
+
+    _nc_err_recovery = recover;
+    if (silent)
+	_nc_suppress_warnings = TRUE;
+    if (setjmp(recovery) == 0) {
+	ENTRY *qp;
+
+	_nc_read_entry_buffer(source, length, literal, silent, NULLHOOK);
+	if (_nc_head != 0
+	    && _nc_resolve_uses2(TRUE, literal)) {
+	    for_entry_list(qp) {
+		result->count++;
+	    }
+	    if ((result->index = typeMalloc(ENTRY *,
+					      (size_t) result->count)) != 0) {
+		int n = 0;
+
+		for_entry_list(qp) {
+		    result->index[n++] = qp;
+		}
+		result->head = _nc_head;
+		result->tail = _nc_tail;
+		_nc_head = 0;
+		_nc_tail = 0;
+	    }
+	}
+    } else {
+	/* a fatal error interrupted reading or resolving the entries */
+	_nc_discard_entries();
+    }
+    _nc_err_recovery = 0;
+}
+
+NCURSES_EXPORT(TIC_COMPILED *)
+_nc_compile_source(const char *source, size_t length, int flags)
+{
+    TIC_COMPILED *result = 0;
+    ENTRY *save_head;
+    ENTRY *save_tail;
+    bool save_suppress;
+    char *save_source;
+    char *save_type;
+    int save_line;
+    int save_col;
+
+    T((T_CALLED("_nc_compile_source(%p, %lu, %#x)"),
+       (const void *) source, (unsigned long) length, flags));
+
+    if (source == 0)
+	returnVoidPtr(0);
+
+    _nc_lock_global(curses);
+    save_head = _nc_head;
+    save_tail = _nc_tail;
+    save_suppress = _nc_suppress_warnings;
+    _nc_head = 0;
+    _nc_tail = 0;
+
+    /* messages should not show the caller's file, line or terminal name */
+    save_source = _nc_globals.comp_sourcename;
+    save_type = _nc_globals.comp_termtype;
+    save_line = _nc_curr_line;
+    save_col = _nc_curr_col;
+    _nc_globals.comp_sourcename = 0;
+    _nc_globals.comp_termtype = 0;
+
+    if ((result = typeCalloc(TIC_COMPILED, 1)) != 0) {
+	compile_entries(result, source, length, flags);
+
+	if (result->head == 0) {
+	    FreeIfNeeded(result->index);
+	    FreeAndNull(result);
+	}
+    }
+    if (_nc_head != 0) {
+	free_list(_nc_head, _nc_tail);
+    }
+
+    /* discard the copy of the source, and any pushed-back token */
+    _nc_reset_input((FILE *) 0, (char *) 0);
+
+    FreeIfNeeded(_nc_globals.comp_sourcename);
+    FreeIfNeeded(_nc_globals.comp_termtype);
+    _nc_globals.comp_sourcename = save_source;
+    _nc_globals.comp_termtype = save_type;
+    _nc_curr_line = save_line;
+    _nc_curr_col = save_col;
+    _nc_suppress_warnings = save_suppress;
+
+    _nc_head = save_head;
+    _nc_tail = save_tail;
+    _nc_unlock_global(curses);
+
+    returnVoidPtr(result);
+}
+
+NCURSES_EXPORT(int)
+_nc_compiled_count(const TIC_COMPILED * compiled)
+{
+    return (compiled != 0) ? compiled->count : 0;
+}
+
+NCURSES_EXPORT(TERMTYPE2 *)
+_nc_compiled_entry(const TIC_COMPILED * compiled, int n)
+{
+    TERMTYPE2 *result = 0;
+
+    if (compiled != 0 && n >= 0 && n < compiled->count)
+	result = &(compiled->index[n]->tterm);
+    return result;
+}
+
+/*
+ * Find the entry which has the given name as one of its aliases.
+ */
+NCURSES_EXPORT(TERMTYPE2 *)
+_nc_compiled_find(const TIC_COMPILED * compiled, const char *name)
+{
+    TERMTYPE2 *result = 0;
+
+    if (compiled != 0 && name != 0) {
+	int n;
+
+	for (n = 0; n < compiled->count; ++n) {
+	    TERMTYPE2 *tp = &(compiled->index[n]->tterm);
+
+	    if (_nc_name_match(tp->term_names, name, "|")) {
+		result = tp;
+		break;
+	    }
+	}
+    }
+    return result;
+}
+
+/*
+ * Store the compiled form of the n'th entry in the buffer, setting *length to
+ * its size.  Returns ERR if there is no such entry or it does not fit.
+ */
+NCURSES_EXPORT(int)
+_nc_compiled_image(const TIC_COMPILED * compiled,
+		   int n,
+		   char *buffer,
+		   unsigned *length,
+		   unsigned limit)
+{
+    TERMTYPE2 *tp = _nc_compiled_entry(compiled, n);
+    int result = ERR;
+
+    if (tp != 0 && buffer != 0 && length != 0) {
+	*length = 0;
+	result = _nc_write_object(tp, buffer, length, limit);
+    }
+    return result;
+}
+
+NCURSES_EXPORT(void)
+_nc_free_compiled(TIC_COMPILED * compiled)
+{
+    T((T_CALLED("_nc_free_compiled(%p)"), (void *) compiled));
+
+    if (compiled != 0) {
+	ENTRY *save_head;
+	ENTRY *save_tail;
+
+	_nc_lock_global(curses);
+	save_head = _nc_head;
+	save_tail = _nc_tail;
+	free_list(compiled->head, compiled->tail);
+	_nc_head = save_head;
+	_nc_tail = save_tail;
+	_nc_unlock_global(curses);
+
+	FreeIfNeeded(compiled->index);
+	free(compiled);
+    }
+    returnVoid;
+}
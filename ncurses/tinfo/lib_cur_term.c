@@ -148,6 +148,7 @@ NCURSES_SP_NAME(del_curterm) (NCURSES_SP_DCLx TERMINAL *termp)
 	_nc_free_termtype(&termp->type);
 #endif
 	_nc_free_termtype2(&TerminalType(termp));
+	_nc_free_ext_index(termp);
 	if (termp == cur)
 	    NCURSES_SP_NAME(set_curterm) (NCURSES_SP_ARGx 0);
 
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2017,2018 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2018,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -49,88 +49,231 @@ same_name(const char *a, const char *b)
 #define same_name(a,b) !strcmp(a,b)
 #endif
 
-NCURSES_EXPORT(int)
-NCURSES_SP_NAME(tigetflag) (NCURSES_SP_DCLx const char *str)
+#if NCURSES_XNAMES
+/*
+ * Extended names are found by a hash table built on the first lookup for
+ * each terminal.  The table holds indices into ext_Names, using linear
+ * probing, so that names which occur more than once are found in the same
+ * order as a linear search would find them.
+ */
+struct ext_index {
+    char **names;		/* the ext_Names array which was indexed */
+    unsigned counts;		/* ...and the number of names it held */
+    unsigned mask;		/* table size - 1 */
+    short *table;		/* indices into ext_Names, -1 if unused */
+};
+
+static unsigned
+ext_hash(const char *name)
 {
-    int result = ABSENT_BOOLEAN;
+    unsigned result = 0;
 
-    T((T_CALLED("tigetflag(%p, %s)"), (void *) SP_PARM, str));
+    while (*name != '\0')
+	result = (result << 5) + result + UChar(*name++);
+    return result;
+}
 
-    if (HasTInfoTerminal(SP_PARM)) {
-	TERMTYPE2 *tp = &TerminalType(TerminalOf(SP_PARM));
-	struct name_table_entry const *entry_ptr;
-	int j = -1;
+static struct ext_index *
+get_ext_index(TERMINAL *termp)
+{
+    TERMTYPE2 *tp = &TerminalType(termp);
+    struct ext_index *result = termp->_ext_index;
+    unsigned counts = NUM_EXT_NAMES(tp);
 
-	entry_ptr = _nc_find_type_entry(str, BOOLEAN, FALSE);
-	if (entry_ptr != 0) {
-	    j = entry_ptr->nte_index;
-	}
-#if NCURSES_XNAMES
-	else {
-	    int i;
-	    for_each_ext_boolean(i, tp) {
-		const char *capname = ExtBoolname(tp, i, boolnames);
-		if (same_name(str, capname)) {
-		    j = i;
-		    break;
+    if (result != 0
+	&& (result->names != tp->ext_Names
+	    || result->counts != counts)) {
+	_nc_free_ext_index(termp);
+	result = 0;
+    }
+    if (result == 0 && counts != 0 && tp->ext_Names != 0) {
+	unsigned size = 8;
+	unsigned n;
+
+	while (size < 2 * counts)
+	    size <<= 1;
+	if ((result = typeMalloc(struct ext_index, 1)) != 0
+	    && (result->table = typeMalloc(short, size)) != 0) {
+	    result->names = tp->ext_Names;
+	    result->counts = counts;
+	    result->mask = size - 1;
+	    for (n = 0; n < size; ++n)
+		result->table[n] = -1;
+	    for (n = 0; n < counts; ++n) {
+		if (tp->ext_Names[n] != 0) {
+		    unsigned h = ext_hash(tp->ext_Names[n]) & result->mask;
+
+		    while (result->table[h] >= 0)
+			h = (h + 1) & result->mask;
+		    result->table[h] = (short) n;
 		}
 	    }
-	}
-#endif
-	if (j >= 0) {
-	    /* note: setupterm forces invalid booleans to false */
-	    result = tp->Booleans[j];
+	    termp->_ext_index = result;
+	} else {
+	    FreeIfNeeded(result);
+	    result = 0;
 	}
     }
-
-    returnCode(result);
+    return result;
 }
 
-#if NCURSES_SP_FUNCS
-NCURSES_EXPORT(int)
-tigetflag(const char *str)
+/*
+ * Return the index in Booleans, Numbers or Strings of the extended
+ * capability with the given name and type, or -1 if there is none.
+ */
+static int
+find_ext_index(TERMINAL *termp, const char *str, int token_type)
 {
-    return NCURSES_SP_NAME(tigetflag) (CURRENT_SCREEN, str);
+    struct ext_index *ip = get_ext_index(termp);
+    int result = -1;
+
+    if (ip != 0) {
+	TERMTYPE2 *tp = &TerminalType(termp);
+	int first = 0;
+	int last = tp->ext_Booleans;
+	int offset = tp->num_Booleans - tp->ext_Booleans;
+	unsigned h = ext_hash(str) & ip->mask;
+
+	if (token_type != BOOLEAN) {
+	    first = last;
+	    last += tp->ext_Numbers;
+	    offset = tp->num_Numbers - tp->ext_Numbers;
+	    if (token_type != NUMBER) {
+		first = last;
+		last += tp->ext_Strings;
+		offset = tp->num_Strings - tp->ext_Strings;
+	    }
+	}
+
+	while (ip->table[h] >= 0) {
+	    int k = ip->table[h];
+
+	    if (k >= first
+		&& k < last
+		&& same_name(str, tp->ext_Names[k])) {
+		result = (k - first) + offset;
+		break;
+	    }
+	    h = (h + 1) & ip->mask;
+	}
+    }
+    return result;
 }
 #endif
 
-NCURSES_EXPORT(int)
-NCURSES_SP_NAME(tigetnum) (NCURSES_SP_DCLx const char *str)
+NCURSES_EXPORT(void)
+_nc_free_ext_index(TERMINAL *termp)
 {
-    int result = CANCELLED_NUMERIC;	/* Solaris returns a -1 on error */
+#if NCURSES_XNAMES
+    struct ext_index *ip = termp->_ext_index;
 
-    T((T_CALLED("tigetnum(%p, %s)"), (void *) SP_PARM, str));
+    if (ip != 0) {
+	FreeIfNeeded(ip->table);
+	free(ip);
+	termp->_ext_index = 0;
+    }
+#else
+    (void) termp;
+#endif
+}
+
+/*
+ * Return the index of the given capability in the terminal's array for the
+ * given type, or -1 if the terminal has no such capability.
+ */
+static int
+find_capability(SCREEN *sp, const char *str, int token_type)
+{
+    int result = -1;
 
-    if (HasTInfoTerminal(SP_PARM)) {
-	TERMTYPE2 *tp = &TerminalType(TerminalOf(SP_PARM));
+    if (HasTInfoTerminal(sp) && str != 0) {
 	struct name_table_entry const *entry_ptr;
-	int j = -1;
 
-	entry_ptr = _nc_find_type_entry(str, NUMBER, FALSE);
+	entry_ptr = _nc_find_type_entry(str, token_type, FALSE);
 	if (entry_ptr != 0) {
-	    j = entry_ptr->nte_index;
+	    result = entry_ptr->nte_index;
 	}
 #if NCURSES_XNAMES
 	else {
-	    int i;
-	    for_each_ext_number(i, tp) {
-		const char *capname = ExtNumname(tp, i, numnames);
-		if (same_name(str, capname)) {
-		    j = i;
-		    break;
-		}
-	    }
+	    result = find_ext_index(TerminalOf(sp), str, token_type);
 	}
 #endif
-	if (j >= 0) {
+    }
+    return result;
+}
+
+static int
+flag_value(SCREEN *sp, int j)
+{
+    int result = ABSENT_BOOLEAN;
+
+    if (HasTInfoTerminal(sp)) {
+	TERMTYPE2 *tp = &TerminalType(TerminalOf(sp));
+
+	if (j >= 0 && j < NUM_BOOLEANS(tp)) {
+	    /* note: setupterm forces invalid booleans to false */
+	    result = tp->Booleans[j];
+	}
+    }
+    return result;
+}
+
+static int
+num_value(SCREEN *sp, int j)
+{
+    int result = CANCELLED_NUMERIC;	/* Solaris returns a -1 on error */
+
+    if (HasTInfoTerminal(sp)) {
+	TERMTYPE2 *tp = &TerminalType(TerminalOf(sp));
+
+	if (j >= 0 && j < NUM_NUMBERS(tp)) {
 	    if (VALID_NUMERIC(tp->Numbers[j]))
 		result = tp->Numbers[j];
 	    else
 		result = ABSENT_NUMERIC;
 	}
     }
+    return result;
+}
+
+static char *
+str_value(SCREEN *sp, int j)
+{
+    char *result = CANCELLED_STRING;
+
+    if (HasTInfoTerminal(sp)) {
+	TERMTYPE2 *tp = &TerminalType(TerminalOf(sp));
+
+	if (j >= 0 && j < NUM_STRINGS(tp)) {
+	    /* note: setupterm forces cancelled strings to null */
+	    result = tp->Strings[j];
+	}
+    }
+    return result;
+}
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetflag) (NCURSES_SP_DCLx const char *str)
+{
+    T((T_CALLED("tigetflag(%p, %s)"), (void *) SP_PARM, str));
+
+    returnCode(flag_value(SP_PARM, find_capability(SP_PARM, str, BOOLEAN)));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetflag(const char *str)
+{
+    return NCURSES_SP_NAME(tigetflag) (CURRENT_SCREEN, str);
+}
+#endif
 
-    returnCode(result);
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetnum) (NCURSES_SP_DCLx const char *str)
+{
+    T((T_CALLED("tigetnum(%p, %s)"), (void *) SP_PARM, str));
+
+    returnCode(num_value(SP_PARM, find_capability(SP_PARM, str, NUMBER)));
 }
 
 #if NCURSES_SP_FUNCS
@@ -144,44 +287,115 @@ tigetnum(const char *str)
 NCURSES_EXPORT(char *)
 NCURSES_SP_NAME(tigetstr) (NCURSES_SP_DCLx const char *str)
 {
-    char *result = CANCELLED_STRING;
-
     T((T_CALLED("tigetstr(%p, %s)"), (void *) SP_PARM, str));
 
-    if (HasTInfoTerminal(SP_PARM)) {
-	TERMTYPE2 *tp = &TerminalType(TerminalOf(SP_PARM));
-	struct name_table_entry const *entry_ptr;
-	int j = -1;
+    returnPtr(str_value(SP_PARM, find_capability(SP_PARM, str, STRING)));
+}
 
-	entry_ptr = _nc_find_type_entry(str, STRING, FALSE);
-	if (entry_ptr != 0) {
-	    j = entry_ptr->nte_index;
-	}
-#if NCURSES_XNAMES
-	else {
-	    int i;
-	    for_each_ext_string(i, tp) {
-		const char *capname = ExtStrname(tp, i, strnames);
-		if (same_name(str, capname)) {
-		    j = i;
-		    break;
-		}
-	    }
-	}
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(char *)
+tigetstr(const char *str)
+{
+    return NCURSES_SP_NAME(tigetstr) (CURRENT_SCREEN, str);
+}
 #endif
-	if (j >= 0) {
-	    /* note: setupterm forces cancelled strings to null */
-	    result = tp->Strings[j];
-	}
-    }
 
-    returnPtr(result);
+/*
+ * The "_id" functions resolve a name once, returning an index which the "_at"
+ * functions use to fetch the value without looking up the name again.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetflag_id) (NCURSES_SP_DCLx const char *str)
+{
+    T((T_CALLED("tigetflag_id(%p, %s)"), (void *) SP_PARM, str));
+
+    returnCode(find_capability(SP_PARM, str, BOOLEAN));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetflag_id(const char *str)
+{
+    return NCURSES_SP_NAME(tigetflag_id) (CURRENT_SCREEN, str);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetnum_id) (NCURSES_SP_DCLx const char *str)
+{
+    T((T_CALLED("tigetnum_id(%p, %s)"), (void *) SP_PARM, str));
+
+    returnCode(find_capability(SP_PARM, str, NUMBER));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetnum_id(const char *str)
+{
+    return NCURSES_SP_NAME(tigetnum_id) (CURRENT_SCREEN, str);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetstr_id) (NCURSES_SP_DCLx const char *str)
+{
+    T((T_CALLED("tigetstr_id(%p, %s)"), (void *) SP_PARM, str));
+
+    returnCode(find_capability(SP_PARM, str, STRING));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetstr_id(const char *str)
+{
+    return NCURSES_SP_NAME(tigetstr_id) (CURRENT_SCREEN, str);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetflag_at) (NCURSES_SP_DCLx int id)
+{
+    T((T_CALLED("tigetflag_at(%p, %d)"), (void *) SP_PARM, id));
+
+    returnCode(flag_value(SP_PARM, id));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetflag_at(int id)
+{
+    return NCURSES_SP_NAME(tigetflag_at) (CURRENT_SCREEN, id);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tigetnum_at) (NCURSES_SP_DCLx int id)
+{
+    T((T_CALLED("tigetnum_at(%p, %d)"), (void *) SP_PARM, id));
+
+    returnCode(num_value(SP_PARM, id));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tigetnum_at(int id)
+{
+    return NCURSES_SP_NAME(tigetnum_at) (CURRENT_SCREEN, id);
+}
+#endif
+
+NCURSES_EXPORT(char *)
+NCURSES_SP_NAME(tigetstr_at) (NCURSES_SP_DCLx int id)
+{
+    T((T_CALLED("tigetstr_at(%p, %d)"), (void *) SP_PARM, id));
+
+    returnPtr(str_value(SP_PARM, id));
 }
 
 #if NCURSES_SP_FUNCS
 NCURSES_EXPORT(char *)
-tigetstr(const char *str)
+tigetstr_at(int id)
 {
-    return NCURSES_SP_NAME(tigetstr) (CURRENT_SCREEN, str);
+    return NCURSES_SP_NAME(tigetstr_at) (CURRENT_SCREEN, id);
 }
 #endif
@@ -133,6 +133,220 @@ _nc_make_hash_table(struct user_table_entry *table,
     printf("/* %d collisions out of %d entries */\n", collisions, tablesize);
 }
 
+/*
+ *	unsigned perfect_hash(string, seed, limit)
+ *
+ *	Computes the seeded hash used for the perfect-hash tables.  This must
+ *	match the function in comp_hash.c.  If limit is nonzero, only that many
+ *	characters of the string are used.
+ */
+static unsigned
+perfect_hash(const char *string, unsigned seed, unsigned limit)
+{
+    unsigned long result = (2166136261UL ^ (seed * 2654435769UL)) & 0xffffffffUL;
+    unsigned used = 0;
+
+    while (*string != '\0' && (limit == 0 || used++ < limit)) {
+	result ^= UChar(*string++);
+	result = (result * 16777619UL) & 0xffffffffUL;
+    }
+    result ^= (result >> 15);
+    result = (result * 0x2c1b3c6dUL) & 0xffffffffUL;
+    result ^= (result >> 12);
+    return (unsigned) result;
+}
+
+#define MAX_SEED 65535
+
+static unsigned *bucket_size;
+
+static int
+compare_buckets(const void *a, const void *b)
+{
+    unsigned p = bucket_size[*(const unsigned *) a];
+    unsigned q = bucket_size[*(const unsigned *) b];
+    int result = (p < q) - (p > q);	/* largest first */
+
+    if (result == 0) {
+	p = *(const unsigned *) a;
+	q = *(const unsigned *) b;
+	result = (p > q) - (p < q);
+    }
+    return result;
+}
+
+/*
+ * Try to place the keys into the given number of slots, using the "hash and
+ * displace" scheme:  the keys are grouped into buckets by their first hash,
+ * and for each bucket, largest first, search for a seed which puts all of its
+ * keys into empty slots.
+ */
+static bool
+place_keys(struct user_table_entry *table,
+	   const unsigned *keys,
+	   unsigned nkeys,
+	   unsigned limit,
+	   unsigned buckets,
+	   unsigned short *seeds,
+	   HashValue * entries,
+	   unsigned slots)
+{
+    unsigned *bucket_of = typeCalloc(unsigned, nkeys);
+    unsigned *order = typeCalloc(unsigned, buckets);
+    unsigned *members = typeCalloc(unsigned, nkeys);
+    unsigned *places = typeCalloc(unsigned, nkeys);
+    bool *used = typeCalloc(bool, slots);
+    bool result = TRUE;
+    unsigned b, k;
+
+    bucket_size = typeCalloc(unsigned, buckets);
+    if (bucket_of == 0
+	|| order == 0
+	|| members == 0
+	|| places == 0
+	|| used == 0
+	|| bucket_size == 0)
+	failed("place_keys");
+
+    for (k = 0; k < nkeys; ++k) {
+	bucket_of[k] = perfect_hash(table[keys[k]].ute_name, 0, limit) % buckets;
+	bucket_size[bucket_of[k]]++;
+    }
+    for (b = 0; b < buckets; ++b) {
+	order[b] = b;
+	seeds[b] = 0;
+    }
+    qsort(order, (size_t) buckets, sizeof(unsigned), compare_buckets);
+    for (k = 0; k < slots; ++k)
+	entries[k] = -1;
+
+    for (b = 0; result && b < buckets && bucket_size[order[b]] != 0; ++b) {
+	unsigned count = 0;
+	unsigned seed;
+
+	for (k = 0; k < nkeys; ++k) {
+	    if (bucket_of[k] == order[b])
+		members[count++] = k;
+	}
+	for (seed = 1; seed <= MAX_SEED; ++seed) {
+	    unsigned j, m;
+
+	    for (m = 0; m < count; ++m) {
+		places[m] = (perfect_hash(table[keys[members[m]]].ute_name,
+					  seed,
+					  limit) % slots);
+		if (used[places[m]])
+		    break;
+		for (j = 0; j < m; ++j) {
+		    if (places[j] == places[m])
+			break;
+		}
+		if (j < m)
+		    break;
+	    }
+	    if (m == count) {
+		for (m = 0; m < count; ++m) {
+		    used[places[m]] = TRUE;
+		    entries[places[m]] = (HashValue) keys[members[m]];
+		}
+		seeds[order[b]] = (unsigned short) seed;
+		break;
+	    }
+	}
+	if (seed > MAX_SEED)
+	    result = FALSE;
+    }
+
+    free(bucket_of);
+    free(order);
+    free(members);
+    free(places);
+    free(used);
+    free(bucket_size);
+    bucket_size = 0;
+    return result;
+}
+
+/*
+ * Write the perfect-hash tables for the names in table[].  A name which occurs
+ * more than once (e.g., a termcap name used for different types) maps to its
+ * last entry, which is the one found first along a chain of the hash table.
+ */
+static void
+make_perfect_hash(struct user_table_entry *table,
+		  unsigned tablesize,
+		  unsigned limit,
+		  const char *root_name)
+{
+    unsigned *keys = typeCalloc(unsigned, tablesize);
+    unsigned short *seeds;
+    HashValue *entries;
+    unsigned nkeys = 0;
+    unsigned buckets;
+    unsigned slots;
+    unsigned n, k;
+
+    if (keys == 0)
+	failed("make_perfect_hash");
+
+    for (n = 0; n < tablesize; n++) {
+	for (k = 0; k < nkeys; ++k) {
+	    const char *a = table[keys[k]].ute_name;
+	    const char *b = table[n].ute_name;
+	    if (limit ? !strncmp(a, b, (size_t) limit) : !strcmp(a, b))
+		break;
+	}
+	keys[k] = n;
+	if (k == nkeys)
+	    ++nkeys;
+    }
+
+    buckets = (nkeys + 3) / 4;
+    if (buckets == 0)
+	buckets = 1;
+    seeds = typeCalloc(unsigned short, buckets);
+    if (seeds == 0)
+	failed("make_perfect_hash");
+
+    for (slots = nkeys ? nkeys : 1;; slots += (slots / 8) + 1) {
+	entries = typeCalloc(HashValue, slots);
+	if (entries == 0)
+	    failed("make_perfect_hash");
+	if (place_keys(table, keys, nkeys, limit, buckets, seeds, entries, slots))
+	    break;
+	free(entries);
+    }
+
+    printf("/* %u names in %u slots */\n", nkeys, slots);
+    printf("static const unsigned short _nc_%s_perfect_seeds[%u] =\n",
+	   root_name,
+	   buckets);
+    printf("%s\n", L_BRACE);
+    for (n = 0; n < buckets; n++) {
+	printf("\t%5u%c\n", seeds[n], n < buckets - 1 ? ',' : ' ');
+    }
+    printf("%s;\n\n", R_BRACE);
+
+    printf("static const HashValue _nc_%s_perfect_slots[%u] =\n",
+	   root_name,
+	   slots);
+    printf("%s\n", L_BRACE);
+    for (n = 0; n < slots; n++) {
+	printf("\t%3d%c\n", entries[n], n < slots - 1 ? ',' : ' ');
+    }
+    printf("%s;\n\n", R_BRACE);
+
+    printf("static const PerfectData _nc_%s_perfect_data =\n", root_name);
+    printf("%s\n", L_BRACE);
+    printf("\t%u, %u, %u, _nc_%s_perfect_seeds, _nc_%s_perfect_slots\n",
+	   buckets, slots, limit, root_name, root_name);
+    printf("%s;\n\n", R_BRACE);
+
+    free(keys);
+    free(seeds);
+    free(entries);
+}
+
 /*
  * This filter reads from standard input a list of tab-delimited columns,
  * (e.g., from Caps.filtered) computes the hash-value of a specified column and
@@ -422,6 +636,12 @@ main(int argc, char **argv)
     printf("\t0\t/* base-of-table */\n");
     printf("%s;\n\n", R_BRACE);
 
+    /* termcap names are looked up by their first two characters */
+    make_perfect_hash(name_table,
+		      tablesize,
+		      (unsigned) (strcmp(root_name, "cap") ? 0 : 2),
+		      root_name);
+
     if (!is_user) {
 	printf("#if (BOOLCOUNT!=%d)||(NUMCOUNT!=%d)||(STRCOUNT!=%d)\n",
 	       BoolCount, NumCount, StrCount);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -58,7 +58,289 @@ static int total_size;
 
 static int make_db_root(const char *);
 
+#if NCURSES_USE_DATABASE
+/*
+ * Each leaf directory of a filesystem database has an index which lets toe
+ * list the directory without reading its entries.  The index records each
+ * file's name, size and modification time, and for a primary name, the
+ * entry's description and checksum.  When tic first writes into a directory,
+ * it drops the records which no longer match their files, and then appends a
+ * record for each file that it writes.  A later record for a name overrides
+ * an earlier one.  Readers trust a record only while its file still has the
+ * recorded size and time.
+ */
+#define DIR_INDEX_HEAD	"# toe index 2\n"
+#define DIR_INDEX_LINE	(PATH_MAX + MAX_TERMINFO_LENGTH + 80)
+
+static void
+free_dir_entry(DIR_ENTRY * entry)
+{
+    FreeIfNeeded(entry->name);
+    FreeIfNeeded(entry->description);
+}
+
+static int
+compare_dir_name(const void *a, const void *b)
+{
+    const char *p = (const char *) a;
+    const DIR_ENTRY *q = (const DIR_ENTRY *) b;
+
+    return strcmp(p, q->name);
+}
+
+static int
+compare_dir_entry(const void *a, const void *b)
+{
+    const DIR_ENTRY *p = (const DIR_ENTRY *) a;
+    const DIR_ENTRY *q = (const DIR_ENTRY *) b;
+    int result = strcmp(p->name, q->name);
+
+    if (result == 0)
+	result = (p->serial > q->serial) - (p->serial < q->serial);
+    return result;
+}
+
+/*
+ * Read a leaf directory's index, returning its records sorted by name, with
+ * only the last record for each name.  Return null if there is no index.
+ */
+NCURSES_EXPORT(DIR_ENTRY *)
+_nc_read_dir_index(const char *path, size_t *count)
+{
+    DIR_ENTRY *result = 0;
+    size_t used = 0;
+    size_t have = 0;
+    char *buffer;
+    FILE *fp;
+
+    if ((buffer = malloc(DIR_INDEX_LINE)) != 0
+	&& (fp = fopen(path, "r")) != 0) {
+	if (fgets(buffer, DIR_INDEX_LINE, fp) != 0
+	    && !strcmp(buffer, DIR_INDEX_HEAD)
+	    && (result = typeCalloc(DIR_ENTRY, have = 10)) != 0) {
+	    /* stop at a partial line, e.g., from an interrupted write */
+	    while (fgets(buffer, DIR_INDEX_LINE, fp) != 0) {
+		DIR_ENTRY *entry;
+		char *next = strchr(buffer, '\t');
+		char *last = strchr(buffer, '\n');
+		char *desc = 0;
+		char kind;
+		long size;
+		long mtime;
+		unsigned long check = 0;
+		int skip = 0;
+
+		if (next == 0 || last == 0 || next > last)
+		    break;
+		*next++ = '\0';
+		*last = '\0';
+		kind = *next++;
+		if (kind == 'P') {
+		    if (sscanf(next, "%ld %ld %lx%n",
+			       &size, &mtime, &check, &skip) != 3
+			|| next[skip] != '\t')
+			break;
+		    desc = next + skip + 1;
+		} else if (kind == 'A') {
+		    if (sscanf(next, "%ld %ld%n", &size, &mtime, &skip) != 2
+			|| next[skip] != '\0')
+			break;
+		} else {
+		    break;
+		}
+
+		if (used + 1 >= have) {
+		    DIR_ENTRY *grown = typeRealloc(DIR_ENTRY, have *= 2, result);
+		    if (grown == 0) {
+			_nc_free_dir_index(result, used);
+			result = 0;
+			break;
+		    }
+		    result = grown;
+		}
+		entry = result + used++;
+		memset(entry, 0, sizeof(*entry));
+		entry->name = strdup(buffer);
+		entry->description = (desc != 0) ? strdup(desc) : 0;
+		entry->checksum = check;
+		entry->size = size;
+		entry->mtime = mtime;
+		entry->serial = (unsigned) used;
+		if (entry->name == 0 || (desc != 0 && entry->description == 0)) {
+		    _nc_free_dir_index(result, used);
+		    result = 0;
+		    break;
+		}
+	    }
+	}
+	fclose(fp);
+    }
+    FreeIfNeeded(buffer);
+
+    if (result != 0) {
+	size_t n, k;
+
+	qsort(result, used, sizeof(DIR_ENTRY), compare_dir_entry);
+	for (n = k = 0; n < used; ++n) {
+	    if (n + 1 < used && !strcmp(result[n].name, result[n + 1].name)) {
+		free_dir_entry(result + n);
+	    } else {
+		result[k++] = result[n];
+	    }
+	}
+	used = k;
+    }
+    *count = used;
+    return result;
+}
+
+/*
+ * Find the record for a file, provided that it matches the file's size and
+ * modification time.
+ */
+NCURSES_EXPORT(DIR_ENTRY *)
+_nc_find_dir_entry(DIR_ENTRY * list,
+		   size_t count,
+		   const char *name,
+		   long size,
+		   long mtime)
+{
+    DIR_ENTRY *result = 0;
+
+    if (list != 0 && count != 0) {
+	result = (DIR_ENTRY *) bsearch(name, list, count, sizeof(DIR_ENTRY),
+				       compare_dir_name);
+	if (result != 0
+	    && (result->size != size || result->mtime != mtime))
+	    result = 0;
+    }
+    return result;
+}
+
+NCURSES_EXPORT(void)
+_nc_free_dir_index(DIR_ENTRY * list, size_t count)
+{
+    if (list != 0) {
+	while (count != 0)
+	    free_dir_entry(list + --count);
+	free(list);
+    }
+}
+#endif /* NCURSES_USE_DATABASE */
+
+static unsigned long
+string_sum(const char *value)
+{
+    unsigned long result = 0;
+
+    if ((intptr_t) value == (intptr_t) (-1)) {
+	result = ~result;
+    } else if (value) {
+	while (*value) {
+	    result += UChar(*value);
+	    ++value;
+	}
+    }
+    return result;
+}
+
+/*
+ * Sum the names and capabilities of an entry, which toe uses to tell whether
+ * entries in different databases differ.
+ */
+NCURSES_EXPORT(unsigned long)
+_nc_entry_checksum(TERMTYPE2 *tp)
+{
+    unsigned long result = string_sum(tp->term_names);
+    unsigned i;
+
+    for (i = 0; i < NUM_BOOLEANS(tp); i++) {
+	result += (unsigned long) (tp->Booleans[i]);
+    }
+    for (i = 0; i < NUM_NUMBERS(tp); i++) {
+	result += (unsigned long) (tp->Numbers[i]);
+    }
+    for (i = 0; i < NUM_STRINGS(tp); i++) {
+	result += string_sum(tp->Strings[i]);
+    }
+    return result;
+}
+
 #if !USE_HASHED_DB
+static const char dirnames[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+static bool verified[sizeof(dirnames)];
+#if NCURSES_USE_DATABASE
+static FILE *leaf_index[sizeof(dirnames)];
+
+static void
+put_dir_entry(FILE *fp, const DIR_ENTRY * entry)
+{
+    if (entry->description != 0) {
+	if (strlen(entry->name) + strlen(entry->description) + 80
+	    < DIR_INDEX_LINE
+	    && strchr(entry->description, '\n') == 0) {
+	    fprintf(fp, "%s\tP %ld %ld %lx\t%s\n",
+		    entry->name,
+		    entry->size,
+		    entry->mtime,
+		    entry->checksum,
+		    entry->description);
+	}
+    } else {
+	fprintf(fp, "%s\tA %ld %ld\n",
+		entry->name,
+		entry->size,
+		entry->mtime);
+    }
+}
+
+/*
+ * Append a record for a file which we have written, given the compiled entry
+ * if it is a copy rather than a link.
+ */
+static void
+update_leaf_index(char *filename, char *buffer, unsigned length)
+{
+    char *name = filename + LEAF_LEN + 1;
+    char *s = (strchr) (dirnames, *name);
+    struct stat sb;
+    FILE *fp;
+
+    if (*name != '\0'
+	&& s != 0
+	&& (fp = leaf_index[s - dirnames]) != 0
+	&& strpbrk(name, "\t\n") == 0
+	&& stat(filename, &sb) == 0) {
+	DIR_ENTRY entry;
+	TERMTYPE2 term;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.name = name;
+	entry.size = (long) sb.st_size;
+	entry.mtime = (long) sb.st_mtime;
+	if (buffer == 0) {
+	    put_dir_entry(fp, &entry);
+	} else if (_nc_read_termtype(&term, buffer, (int) length) > 0) {
+	    /* toe checksums the entry as it reads it, not as we compiled it */
+	    if (!strcmp(_nc_first_name(term.term_names), name)) {
+		char *desc = strrchr(term.term_names, '|');
+
+		entry.description = ((desc != 0)
+				     ? (desc + 1)
+				     : strchr(name, '\0'));
+		entry.checksum = _nc_entry_checksum(&term);
+	    }
+	    put_dir_entry(fp, &entry);
+	    _nc_free_termtype2(&term);
+	}
+	/* "tic -j" processes share the stream, so write whole records */
+	fflush(fp);
+    }
+}
+#else
+#define update_leaf_index(filename, buffer, length)	/* nothing */
+#endif /* NCURSES_USE_DATABASE */
+
 static void
 write_file(char *filename, TERMTYPE2 *tp)
 {
@@ -97,10 +379,78 @@ write_file(char *filename, TERMTYPE2 *tp)
 	} else {
 	    fclose(fp);
 	    DEBUG(1, ("Created %s", filename));
+	    update_leaf_index(filename, buffer, offset);
 	}
     }
 }
 
+#if NCURSES_USE_DATABASE
+static bool
+leaf_path(char *dst, size_t limit, const char *leaf, const char *name)
+{
+    bool result = FALSE;
+
+    if (strlen(leaf) + strlen(name) + 2 <= limit) {
+	_nc_STRCPY(dst, leaf, limit);
+	_nc_STRCAT(dst, "/", limit);
+	_nc_STRCAT(dst, name, limit);
+	result = TRUE;
+    }
+    return result;
+}
+
+/*
+ * Rewrite a leaf directory's index, keeping only the records which still
+ * match their files, and open it to append records for the files we write.
+ */
+static void
+open_leaf_index(int code, size_t slot)
+{
+    char leaf[sizeof(LEAF_FMT)];
+    char path[sizeof(LEAF_FMT) + sizeof(DIR_INDEX)];
+    char temp[sizeof(LEAF_FMT) + sizeof(DIR_INDEX) + 4];
+    char name[PATH_MAX];
+    DIR_ENTRY *list;
+    size_t count;
+    size_t n;
+    FILE *fp;
+    bool ok = FALSE;
+
+    _nc_SPRINTF(leaf, _nc_SLIMIT(sizeof(leaf)) LEAF_FMT, code);
+    _nc_SPRINTF(path, _nc_SLIMIT(sizeof(path)) "%s/%s", leaf, DIR_INDEX);
+    _nc_SPRINTF(temp, _nc_SLIMIT(sizeof(temp)) "%s.new", path);
+
+    list = _nc_read_dir_index(path, &count);
+    if ((fp = fopen(temp, "w")) != 0) {
+	fputs(DIR_INDEX_HEAD, fp);
+	for (n = 0; n < count; ++n) {
+	    struct stat sb;
+
+	    if (leaf_path(name, sizeof(name), leaf, list[n].name)) {
+		if (stat(name, &sb) == 0
+		    && S_ISREG(sb.st_mode)
+		    && (long) sb.st_size == list[n].size
+		    && (long) sb.st_mtime == list[n].mtime)
+		    put_dir_entry(fp, list + n);
+	    }
+	}
+	ok = !ferror(fp);
+	if (fclose(fp) != 0)
+	    ok = FALSE;
+	if (!ok || rename(temp, path) != 0) {
+	    (void) unlink(temp);
+	    ok = FALSE;
+	}
+    }
+    _nc_free_dir_index(list, count);
+
+    if (ok)
+	leaf_index[slot] = fopen(path, "a");
+}
+#else
+#define open_leaf_index(code, slot)	/* nothing */
+#endif /* NCURSES_USE_DATABASE */
+
 /*
  * Check for access rights to destination directories
  * Create any directories which don't exist.
@@ -111,9 +461,6 @@ write_file(char *filename, TERMTYPE2 *tp)
 static void
 check_writeable(int code)
 {
-    static const char dirnames[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
-    static bool verified[sizeof(dirnames)];
-
     char dir[sizeof(LEAF_FMT)];
     char *s = 0;
 
@@ -128,6 +475,7 @@ check_writeable(int code)
 	_nc_err_abort("%s/%s: permission denied", _nc_tic_dir(0), dir);
     }
 
+    open_leaf_index(code, (size_t) (s - dirnames));
     verified[s - dirnames] = TRUE;
 }
 #endif /* !USE_HASHED_DB */
@@ -195,6 +543,9 @@ make_db_root(const char *path)
 		       ,0777
 #endif
 		);
+	    /* another "tic -j" process may have made it meanwhile */
+	    if (rc < 0 && errno == EEXIST)
+		rc = 0;
 	} else if (_nc_access(path, R_OK | W_OK | X_OK) < 0) {
 	    rc = -1;		/* permission denied */
 	} else if (!(S_ISDIR(statbuf.st_mode))) {
@@ -213,6 +564,9 @@ _nc_set_writedir(const char *dir)
 {
     const char *destination;
     char actual[PATH_MAX];
+#if !USE_HASHED_DB
+    size_t n;
+#endif
 
     if (dir == 0
 #ifndef USE_ROOT_ENVIRON
@@ -243,6 +597,15 @@ _nc_set_writedir(const char *dir)
 #if USE_HASHED_DB
     make_db_path(actual, destination, sizeof(actual));
 #else
+    for (n = 0; n < sizeof(dirnames); ++n) {
+#if NCURSES_USE_DATABASE
+	if (leaf_index[n] != 0) {
+	    fclose(leaf_index[n]);
+	    leaf_index[n] = 0;
+	}
+#endif
+	verified[n] = FALSE;
+    }
     if (chdir(_nc_tic_dir(destination)) < 0
 	|| getcwd(actual, sizeof(actual)) == 0)
 	_nc_err_abort("%s: not a directory", destination);
@@ -521,6 +884,7 @@ _nc_write_entry(TERMTYPE2 *const tp)
 		}
 	    } else {
 		DEBUG(1, ("Linked %s", linkname));
+		update_leaf_index(linkname, 0, 0);
 	    }
 	}
 #else /* just make copies */
@@ -530,6 +894,39 @@ _nc_write_entry(TERMTYPE2 *const tp)
 #endif /* USE_HASHED_DB */
 }
 
+/*
+ * Prepare the directories which _nc_write_entry() will write for an entry,
+ * e.g., before forking processes which write entries in parallel, so that
+ * only this process updates the directories' indices.
+ */
+NCURSES_EXPORT(void)
+_nc_write_prepare(TERMTYPE2 *const tp)
+{
+#if !USE_HASHED_DB
+    char name_list[MAX_TERMINFO_LENGTH];
+    char *next;
+    char *last;
+
+    if (tp->term_names != 0
+	&& strlen(tp->term_names) < sizeof(name_list)) {
+	_nc_STRCPY(name_list, tp->term_names, sizeof(name_list));
+	/* the last name is the description, unless it is the only one */
+	if ((last = strrchr(name_list, '|')) != 0)
+	    *last = '\0';
+	for (next = name_list; next != 0; next = last) {
+	    if ((last = strchr(next, '|')) != 0)
+		*last++ = '\0';
+	    if (*next != '\0'
+		&& strchr(next, '/') == 0
+		&& strchr(dirnames, *next) != 0)
+		check_writeable(UChar(*next));
+	}
+    }
+#else
+    (void) tp;
+#endif
+}
+
 static size_t
 fake_write(char *dst,
 	   unsigned *offset,
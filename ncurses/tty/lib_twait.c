@@ -77,7 +77,11 @@
 
 MODULE_ID("$Id: lib_twait.c,v 1.73 2018/06/23 21:35:06 tom Exp $")
 
-static long
+/*
+ * Return the number of milliseconds elapsed since the given time, or
+ * initialize it if "first" is set.
+ */
+NCURSES_EXPORT(long)
 _nc_gettime(TimeType * t0, int first)
 {
     long res;
@@ -131,11 +135,109 @@ _nc_eventlist_timeout(_nc_eventlist * evl)
 }
 #endif /* NCURSES_WGETCH_EVENTS */
 
-#if (USE_FUNC_POLL || HAVE_SELECT)
-#  define MAYBE_UNUSED
+#if USE_EPOLL
+#define MAX_EPOLL 16
+
+/*
+ * Build the epoll set for the screen's input and mouse descriptors, together
+ * with any which were registered using register_fd().  The set persists until
+ * one of those changes.  If epoll cannot handle one of the descriptors (e.g.,
+ * a regular file), mark the set unusable so we use poll/select until then.
+ */
+static bool
+epoll_rebuild(SCREEN *sp)
+{
+    struct epoll_event ev;
+    bool ok = TRUE;
+    int n;
+
+    if (sp->_epoll_fd >= 0)
+	close(sp->_epoll_fd);
+#ifdef EPOLL_CLOEXEC
+    sp->_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
 #else
-#  define MAYBE_UNUSED GCC_UNUSED
+    sp->_epoll_fd = epoll_create(2 + sp->_user_fd_count);
 #endif
+    sp->_epoll_mouse = sp->_mouse_fd;
+    sp->_user_fd_dirty = FALSE;
+
+    if (sp->_epoll_fd < 0) {
+	ok = FALSE;
+    } else {
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+
+	ev.data.fd = sp->_ifd;
+	ok = (epoll_ctl(sp->_epoll_fd, EPOLL_CTL_ADD, sp->_ifd, &ev) == 0);
+
+	if (ok && sp->_mouse_fd >= 0) {
+	    ev.data.fd = sp->_mouse_fd;
+	    ok = (epoll_ctl(sp->_epoll_fd, EPOLL_CTL_ADD, sp->_mouse_fd, &ev) == 0);
+	}
+	for (n = 0; ok && n < sp->_user_fd_count; ++n) {
+	    int fd = sp->_user_fds[n].fd;
+
+	    ev.data.fd = fd;
+	    ok = (epoll_ctl(sp->_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0);
+	}
+	if (!ok) {
+	    close(sp->_epoll_fd);
+	}
+    }
+    if (!ok)
+	sp->_epoll_fd = -2;	/* retry only after the descriptors change */
+    TR(TRACE_IEVENT, ("rebuilt epoll set: %d", sp->_epoll_fd));
+    return ok;
+}
+
+static int
+epoll_timed_wait(SCREEN *sp, int mode, int milliseconds, int *timeleft)
+{
+    struct epoll_event events[MAX_EPOLL];
+    TimeType t0;
+    long starttime, returntime;
+    int result = TW_NONE;
+    int count;
+    int n;
+
+    TR(TRACE_IEVENT, ("start epoll twait: %d milliseconds, mode: %d",
+		      milliseconds, mode));
+
+    starttime = _nc_gettime(&t0, TRUE);
+    count = epoll_wait(sp->_epoll_fd, events, MAX_EPOLL, milliseconds);
+    returntime = _nc_gettime(&t0, FALSE);
+
+    for (n = 0; n < count; ++n) {
+	int fd = events[n].data.fd;
+
+	if (fd == sp->_ifd) {
+	    result |= TW_INPUT;
+	} else if (fd == sp->_mouse_fd) {
+	    result |= TW_MOUSE;
+	} else {
+	    int k;
+
+	    for (k = 0; k < sp->_user_fd_count; ++k) {
+		if (sp->_user_fds[k].fd == fd) {
+		    sp->_user_fds[k].ready = TRUE;
+		    result |= TW_USER;
+		    break;
+		}
+	    }
+	}
+    }
+    result &= mode;
+
+    if (milliseconds >= 0)
+	milliseconds -= (int) (returntime - starttime);
+    if (timeleft)
+	*timeleft = milliseconds;
+
+    TR(TRACE_IEVENT, ("end epoll twait: returned %d (%d), remaining time %d msec",
+		      result, errno, milliseconds));
+    return result;
+}
+#endif /* USE_EPOLL */
 
 #if (USE_FUNC_POLL || HAVE_SELECT)
 #  define MAYBE_UNUSED
@@ -152,10 +254,14 @@ _nc_eventlist_timeout(_nc_eventlist * evl)
  *	TW_MOUSE   2 - mouse descriptor, if any
  *	TW_ANY     3 - either input or mouse.
  *      TW_EVENT   4 -
+ *	TW_USER    8 - descriptors registered with register_fd().
  * Experimental:  if NCURSES_WGETCH_EVENTS is defined, (mode & 4) determines
  * whether to pay attention to evl argument.  If set, the smallest of
  * millisecond and of timeout of evl is taken.
  *
+ * Registered descriptors which are readable are marked for the caller to
+ * dispatch with _nc_user_fd_dispatch().
+ *
  * We return a mask that corresponds to the mode (e.g., 2 for mouse activity).
  *
  * If the milliseconds given are -1, the wait blocks until activity on the
@@ -174,9 +280,14 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #if (USE_FUNC_POLL || HAVE_SELECT)
     int fd;
 #endif
+#if NCURSES_EXT_FUNCS && (USE_FUNC_POLL || HAVE_SELECT)
+    int user_count = 0;
+#endif
 
 #ifdef NCURSES_WGETCH_EVENTS
     int timeout_is_event = 0;
+#endif
+#if defined(NCURSES_WGETCH_EVENTS) || (NCURSES_EXT_FUNCS && (USE_FUNC_POLL || HAVE_SELECT))
     int n;
 #endif
 
@@ -184,6 +295,10 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #define MIN_FDS 2
     struct pollfd fd_list[MIN_FDS];
     struct pollfd *fds = fd_list;
+    int num_fds = MIN_FDS;
+    int input_at = -1;
+    int mouse_at = -1;
+    int user_at = -1;
 #elif defined(__BEOS__)
 #elif HAVE_SELECT
     fd_set set;
@@ -204,6 +319,28 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
     TR(TRACE_IEVENT, ("start twait: %d milliseconds, mode: %d",
 		      milliseconds, mode));
 
+#if USE_EPOLL
+    if ((mode & TW_USER)
+	&& (mode & TW_ANY) == TW_ANY
+#ifdef NCURSES_WGETCH_EVENTS
+	&& !((mode & TW_EVENT) && evl)
+#endif
+	) {
+	if (sp->_user_fd_dirty
+	    || sp->_epoll_fd == -1
+	    || sp->_epoll_mouse != sp->_mouse_fd) {
+	    epoll_rebuild(sp);
+	}
+	if (sp->_epoll_fd >= 0)
+	    return epoll_timed_wait(sp, mode, milliseconds, timeleft);
+    }
+#endif
+
+#if NCURSES_EXT_FUNCS && (USE_FUNC_POLL || HAVE_SELECT)
+    if ((mode & TW_USER) && sp != 0)
+	user_count = sp->_user_fd_count;
+#endif
+
 #ifdef NCURSES_WGETCH_EVENTS
     if (mode & TW_EVENT) {
 	int event_delay = _nc_eventlist_timeout(evl);
@@ -232,26 +369,43 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #if USE_FUNC_POLL
     memset(fd_list, 0, sizeof(fd_list));
 
+#if NCURSES_EXT_FUNCS
+    num_fds += user_count;
+#endif
 #ifdef NCURSES_WGETCH_EVENTS
-    if ((mode & TW_EVENT) && evl) {
+    if ((mode & TW_EVENT) && evl)
+	num_fds += evl->count;
+#endif
+    if (num_fds > MIN_FDS) {
 	if (fds == fd_list)
-	    fds = typeMalloc(struct pollfd, MIN_FDS + evl->count);
+	    fds = typeCalloc(struct pollfd, num_fds);
 	if (fds == 0)
 	    return TW_NONE;
     }
-#endif
 
     if (mode & TW_INPUT) {
+	input_at = count;
 	fds[count].fd = sp->_ifd;
 	fds[count].events = POLLIN;
 	count++;
     }
     if ((mode & TW_MOUSE)
 	&& (fd = sp->_mouse_fd) >= 0) {
+	mouse_at = count;
 	fds[count].fd = fd;
 	fds[count].events = POLLIN;
 	count++;
     }
+#if NCURSES_EXT_FUNCS
+    if (user_count) {
+	user_at = count;
+	for (n = 0; n < user_count; ++n) {
+	    fds[count].fd = sp->_user_fds[n].fd;
+	    fds[count].events = POLLIN;
+	    count++;
+	}
+    }
+#endif
 #ifdef NCURSES_WGETCH_EVENTS
     if ((mode & TW_EVENT) && evl) {
 	for (n = 0; n < evl->count; ++n) {
@@ -356,6 +510,13 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 	FD_SET(fd, &set);
 	count = max(fd, count) + 1;
     }
+#if NCURSES_EXT_FUNCS
+    for (n = 0; n < user_count; ++n) {
+	fd = sp->_user_fds[n].fd;
+	FD_SET(fd, &set);
+	count = max(fd + 1, count);
+    }
+#endif
 #ifdef NCURSES_WGETCH_EVENTS
     if ((mode & TW_EVENT) && evl) {
 	for (n = 0; n < evl->count; ++n) {
@@ -481,12 +642,20 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 	if (result > 0) {
 	    result = 0;
 #if USE_FUNC_POLL
-	    for (count = 0; count < MIN_FDS; count++) {
-		if ((mode & (1 << count))
-		    && (fds[count].revents & POLLIN)) {
-		    result |= (1 << count);
+	    if (input_at >= 0
+		&& (fds[input_at].revents & POLLIN))
+		result |= TW_INPUT;
+	    if (mouse_at >= 0
+		&& (fds[mouse_at].revents & POLLIN))
+		result |= TW_MOUSE;
+#if NCURSES_EXT_FUNCS
+	    for (n = 0; n < user_count; ++n) {
+		if (fds[user_at + n].revents & (POLLIN | POLLHUP | POLLERR)) {
+		    sp->_user_fds[n].ready = TRUE;
+		    result |= TW_USER;
 		}
 	    }
+#endif
 #elif defined(__BEOS__)
 	    result = TW_INPUT;	/* redundant, but simple */
 #elif HAVE_SELECT
@@ -497,6 +666,14 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 	    if ((mode & TW_INPUT)
 		&& FD_ISSET(sp->_ifd, &set))
 		result |= TW_INPUT;
+#if NCURSES_EXT_FUNCS
+	    for (n = 0; n < user_count; ++n) {
+		if (FD_ISSET(sp->_user_fds[n].fd, &set)) {
+		    sp->_user_fds[n].ready = TRUE;
+		    result |= TW_USER;
+		}
+	    }
+#endif
 #endif
 	} else
 	    result = 0;
@@ -507,10 +684,8 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #endif
 
 #if USE_FUNC_POLL
-#ifdef NCURSES_WGETCH_EVENTS
     if (fds != fd_list)
 	free((char *) fds);
-#endif
 #endif
 
     return (result);
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 2002-2011,2016 Free Software Foundation, Inc.              *
+ * Copyright (c) 2002-2016,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -42,6 +42,51 @@
 
 MODULE_ID("$Id: lib_get_wch.c,v 1.24 2016/05/28 23:36:34 tom Exp $")
 
+/*
+ * In a UTF-8 locale, decode the character directly, checking only that the
+ * continuation bytes are well-formed.  A byte which cannot continue the
+ * character is pushed back to begin the next one.
+ */
+static int
+get_utf8(SCREEN *sp, WINDOW *win, int *value)
+{
+    int code = _nc_wgetch(win, value, TRUE EVENTLIST_2nd((_nc_eventlist *) 0));
+
+    if (code == OK && *value >= 0x80) {
+	int need = UTF8_LENGTH(*value);
+	unsigned ucs = UTF8_LEAD(*value, need);
+	int have;
+
+	if (need == 0) {
+	    T(("not a UTF-8 lead byte %#x", *value));
+	    code = ERR;
+	}
+	for (have = 1; code == OK && have < need; ++have) {
+	    int next;
+
+	    code = _nc_wgetch(win, &next, TRUE EVENTLIST_2nd((_nc_eventlist
+							      *) 0));
+	    if (code == ERR) {
+		break;
+	    } else if (code == KEY_CODE_YES || !UTF8_CONT(next)) {
+		safe_ungetch(sp, next);
+		code = ERR;
+	    } else {
+		ucs = (ucs << 6) | (unsigned) (next & 0x3f);
+	    }
+	}
+	if (code == OK) {
+	    if (UTF8_VALID(ucs, need)) {
+		*value = (int) ucs;
+	    } else {
+		T(("invalid UTF-8 value %#x", ucs));
+		code = ERR;
+	    }
+	}
+    }
+    return code;
+}
+
 NCURSES_EXPORT(int)
 wget_wch(WINDOW *win, wint_t *result)
 {
@@ -62,7 +107,9 @@ wget_wch(WINDOW *win, wint_t *result)
     _nc_lock_global(curses);
     sp = _nc_screen_of(win);
 
-    if (sp != 0) {
+    if (sp != 0 && sp->_screen_unicode) {
+	code = get_utf8(sp, win, &value);
+    } else if (sp != 0) {
 	size_t count = 0;
 
 	for (;;) {
@@ -118,3 +165,58 @@ wget_wch(WINDOW *win, wint_t *result)
     T(("result %#o", value));
     returnCode(code);
 }
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Read up to "length" wide characters, waiting (according to the window's
+ * input options) only for the first.  The rest are those which are available
+ * immediately, e.g., from a paste.  Stop before a function key, leaving it for
+ * wget_wch; return 0 if that is the first input.  The lock is held for the
+ * whole batch, so other threads do not read from the fifo in the middle.
+ */
+NCURSES_EXPORT(int)
+wget_wchs(WINDOW *win, wint_t *buffer, int length)
+{
+    SCREEN *sp = _nc_screen_of(win);
+    int result = ERR;
+
+    T((T_CALLED("wget_wchs(%p,%p,%d)"), (void *) win, (void *) buffer, length));
+
+    _nc_lock_global(curses);
+    if (sp != 0 && buffer != 0 && length > 0) {
+	wint_t wch;
+	int code = wget_wch(win, &wch);
+
+	if (code == KEY_CODE_YES) {
+	    safe_ungetch(sp, (int) wch);
+	    result = 0;
+	} else if (code == OK) {
+	    buffer[0] = wch;
+	    result = 1;
+	    if (sp->_echo
+		|| sp->_cbreak > 1
+		|| (!sp->_notty && !sp->_raw && !sp->_cbreak)) {
+		/* echo, half-delay and cooked modes get one character */
+		;
+	    } else if (sp->_screen_unicode) {
+		result += _nc_fifo_utf8(sp, buffer + 1, length - 1);
+	    } else {
+		int save_delay = win->_delay;
+
+		win->_delay = 0;
+		while (result < length) {
+		    code = wget_wch(win, &wch);
+		    if (code == KEY_CODE_YES)
+			safe_ungetch(sp, (int) wch);
+		    if (code != OK)
+			break;
+		    buffer[result++] = wch;
+		}
+		win->_delay = save_delay;
+	    }
+	}
+    }
+    _nc_unlock_global(curses);
+    returnCode(result);
+}
+#endif /* NCURSES_EXT_FUNCS */
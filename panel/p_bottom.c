@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -63,6 +63,7 @@ bottom_panel(PANEL * pan)
 	  if (pan->above)
 	    pan->above->below = pan;
 	  _nc_bottom_panel->above = pan;
+	  PANEL_INDEX_STALE();
 
 	  dStack("<lb%d>", 9, pan);
 	}
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -51,6 +51,8 @@ del_panel(PANEL * pan)
       {
 	GetHook(pan);
 	HIDE_PANEL(pan, err, OK);
+	if (EMPTY_STACK())
+	  PANEL_INDEX_FREE();
 	free((void *)pan);
       }
     }
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2008,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -55,6 +55,7 @@ move_panel(PANEL * pan, int starty, int startx)
 	  PANEL_UPDATE(pan, (PANEL *) 0);
 	}
       rc = mvwin(pan->win, starty, startx);
+      PANEL_INDEX_STALE();
     }
   returnCode(rc);
 }
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2005,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -54,6 +54,7 @@ replace_panel(PANEL * pan, WINDOW *win)
 	  PANEL_UPDATE(pan, (PANEL *) 0);
 	}
       pan->win = win;
+      PANEL_INDEX_STALE();
       rc = OK;
     }
   returnCode(rc);
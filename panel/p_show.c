@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2005,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -63,6 +63,7 @@ show_panel(PANEL * pan)
       pan->below = _nc_top_panel;
       pan->above = (PANEL *) 0;
       _nc_top_panel = pan;
+      PANEL_INDEX_STALE();
 
       err = OK;
 
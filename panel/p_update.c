@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2009,2010 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2010,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -39,10 +39,588 @@
 
 MODULE_ID("$Id: p_update.c,v 1.11 2010/01/23 21:22:16 tom Exp $")
 
+/*
+ * Return the cell of the grid containing the given line or column.
+ */
+static int
+grid_cell(int value, int size, int limit)
+{
+  int result = (value > 0) ? (value / size) : 0;
+
+  return (result < limit) ? result : (limit - 1);
+}
+
+/*
+ * Check if the index still matches the stack.  Besides the changes which are
+ * made through the panel library, the application may have moved or resized
+ * a panel's window directly.
+ */
+static bool
+index_is_current(struct panel_index *idx, PANEL * bottom)
+{
+  PANEL *pan;
+  int n = 0;
+
+  if (idx->stale)
+    return FALSE;
+
+  for (pan = bottom; pan != 0; pan = pan->above)
+    {
+      PANEL_EXTENT *ext;
+
+      if (n >= idx->count)
+	return FALSE;
+      ext = &(idx->extent[n++]);
+      if (ext->pan != pan
+	  || ext->y1 != PSTARTY(pan)
+	  || ext->x1 != PSTARTX(pan)
+	  || ext->y2 != PENDY(pan)
+	  || ext->x2 != PENDX(pan))
+	return FALSE;
+    }
+  return (n == idx->count);
+}
+
+/*
+ * Record the extents of the panels in the stack, and list the panels which
+ * cover each cell of the grid.  The bottom (stdscr) panel is never above
+ * another, so it is not listed.
+ */
+static bool
+build_index(struct panel_index *idx, PANEL * bottom)
+{
+  PANEL *pan;
+  int count = 0;
+  int maxy = 0;
+  int maxx = 0;
+  int cells;
+  int n, row, col;
+
+  idx->stale = TRUE;
+  idx->count = 0;
+
+  for (pan = bottom; pan != 0; pan = pan->above)
+    ++count;
+  if (count > idx->extent_limit)
+    {
+      idx->extent = typeRealloc(PANEL_EXTENT, (size_t) count, idx->extent);
+      idx->extent_limit = (idx->extent != 0) ? count : 0;
+      if (idx->extent == 0)
+	return FALSE;
+    }
+
+  if (count > idx->above_limit)
+    {
+      idx->above = typeRealloc(int, (size_t) count, idx->above);
+      idx->above_limit = (idx->above != 0) ? count : 0;
+      if (idx->above == 0)
+	return FALSE;
+    }
+
+  for (n = 0, pan = bottom; pan != 0; pan = pan->above, ++n)
+    {
+      PANEL_EXTENT *ext = &(idx->extent[n]);
+
+      ext->pan = pan;
+      ext->y1 = PSTARTY(pan);
+      ext->x1 = PSTARTX(pan);
+      ext->y2 = PENDY(pan);
+      ext->x2 = PENDX(pan);
+      ext->seen = 0;
+      if (maxy < ext->y2)
+	maxy = ext->y2;
+      if (maxx < ext->x2)
+	maxx = ext->x2;
+    }
+
+  idx->rows = (maxy / PANEL_GRID_ROWS) + 1;
+  idx->cols = (maxx / PANEL_GRID_COLS) + 1;
+  cells = idx->rows * idx->cols;
+  if (cells + 1 > idx->first_limit)
+    {
+      idx->first = typeRealloc(int, (size_t) (cells + 1), idx->first);
+      idx->first_limit = (idx->first != 0) ? (cells + 1) : 0;
+      if (idx->first == 0)
+	return FALSE;
+    }
+  memset(idx->first, 0, sizeof(int) * (size_t) (cells + 1));
+
+  /* count the panels covering each cell */
+  for (n = 1; n < count; ++n)
+    {
+      PANEL_EXTENT *ext = &(idx->extent[n]);
+      int r2 = grid_cell(ext->y2, PANEL_GRID_ROWS, idx->rows);
+      int c2 = grid_cell(ext->x2, PANEL_GRID_COLS, idx->cols);
+
+      for (row = grid_cell(ext->y1, PANEL_GRID_ROWS, idx->rows);
+	   row <= r2;
+	   ++row)
+	{
+	  for (col = grid_cell(ext->x1, PANEL_GRID_COLS, idx->cols);
+	       col <= c2;
+	       ++col)
+	    {
+	      idx->first[(row * idx->cols) + col]++;
+	    }
+	}
+    }
+
+  /* make each count the end of that cell's list */
+  for (n = 1; n < cells; ++n)
+    idx->first[n] += idx->first[n - 1];
+  idx->first[cells] = idx->first[cells - 1];
+
+  if (idx->first[cells] > idx->cover_limit)
+    {
+      idx->cover = typeRealloc(int, (size_t) idx->first[cells], idx->cover);
+      idx->cover_limit = (idx->cover != 0) ? idx->first[cells] : 0;
+      if (idx->cover == 0)
+	return FALSE;
+    }
+
+  /*
+   * Fill the lists from the top of the stack down, moving each cell's
+   * start back over its list, so each list is ordered bottom first.
+   */
+  for (n = count - 1; n > 0; --n)
+    {
+      PANEL_EXTENT *ext = &(idx->extent[n]);
+      int r2 = grid_cell(ext->y2, PANEL_GRID_ROWS, idx->rows);
+      int c2 = grid_cell(ext->x2, PANEL_GRID_COLS, idx->cols);
+
+      for (row = grid_cell(ext->y1, PANEL_GRID_ROWS, idx->rows);
+	   row <= r2;
+	   ++row)
+	{
+	  for (col = grid_cell(ext->x1, PANEL_GRID_COLS, idx->cols);
+	       col <= c2;
+	       ++col)
+	    {
+	      idx->cover[--(idx->first[(row * idx->cols) + col])] = n;
+	    }
+	}
+    }
+
+  idx->count = count;
+  idx->stale = FALSE;
+  return TRUE;
+}
+
+/*
+ * Return a new stamp, to mark the panels found in one search of the grid.
+ */
+static int
+next_stamp(struct panel_index *idx)
+{
+  if (idx->stamp == INT_MAX)
+    {
+      int n;
+
+      for (n = 0; n < idx->count; ++n)
+	idx->extent[n].seen = 0;
+      idx->stamp = 0;
+    }
+  return ++(idx->stamp);
+}
+
+/*
+ * List the panels above the n'th panel of the stack which are listed in the
+ * given cells of the grid.  If those cells hold more entries than there are
+ * panels above, it is quicker to list all of the panels above.
+ */
+static int
+list_above(struct panel_index *idx, int n, int r1, int r2, int c1, int c2)
+{
+  int found = 0;
+  int m;
+
+  if ((r2 - r1 + 1) * (c2 - c1 + 1) > idx->count - n)
+    {
+      for (m = n + 1; m < idx->count; ++m)
+	idx->above[found++] = m;
+    }
+  else
+    {
+      int stamp = next_stamp(idx);
+      int row, col;
+
+      for (row = r1; row <= r2; ++row)
+	{
+	  for (col = c1; col <= c2; ++col)
+	    {
+	      int cell = (row * idx->cols) + col;
+	      int k;
+
+	      for (k = idx->first[cell]; k < idx->first[cell + 1]; ++k)
+		{
+		  m = idx->cover[k];
+		  if (m > n && idx->extent[m].seen != stamp)
+		    {
+		      idx->extent[m].seen = stamp;
+		      idx->above[found++] = m;
+		    }
+		}
+	    }
+	}
+    }
+  return found;
+}
+
+/*
+ * Touch the panels above the n'th panel of the stack which overlap its
+ * touched lines.  Only the panels listed in the cells covering those lines
+ * are checked.
+ */
+static void
+touch_above(struct panel_index *idx, int n)
+{
+  PANEL_EXTENT *ext = &(idx->extent[n]);
+  PANEL *pan = ext->pan;
+  WINDOW *win = pan->win;
+  int top, bottom;
+  int found, k;
+
+  for (top = 0; top <= win->_maxy; ++top)
+    {
+      if (win->_line[top].firstchar != _NOCHANGE)
+	break;
+    }
+  if (top > win->_maxy)
+    return;
+  for (bottom = win->_maxy; bottom > top; --bottom)
+    {
+      if (win->_line[bottom].firstchar != _NOCHANGE)
+	break;
+    }
+
+  found = list_above(idx, n,
+		     grid_cell(ext->y1 + top, PANEL_GRID_ROWS, idx->rows),
+		     grid_cell(ext->y1 + bottom, PANEL_GRID_ROWS, idx->rows),
+		     grid_cell(ext->x1, PANEL_GRID_COLS, idx->cols),
+		     grid_cell(ext->x2, PANEL_GRID_COLS, idx->cols));
+  for (k = 0; k < found; ++k)
+    {
+      PANEL *pan2 = idx->extent[idx->above[k]].pan;
+
+      PANEL_TOUCH(pan, pan2);
+    }
+}
+
+/*
+ * Add the columns x1..x2 to the spans covering a line, merging the spans
+ * which it overlaps or adjoins.
+ */
+static bool
+cover_span(PANEL_LINE * cover, int x1, int x2)
+{
+  int n, m;
+
+  for (n = 0; n < cover->count; ++n)
+    {
+      if (cover->span[n].x2 >= x1 - 1)
+	break;
+    }
+  for (m = n; m < cover->count; ++m)
+    {
+      if (cover->span[m].x1 > x2 + 1)
+	break;
+      if (x1 > cover->span[m].x1)
+	x1 = cover->span[m].x1;
+      if (x2 < cover->span[m].x2)
+	x2 = cover->span[m].x2;
+    }
+
+  if (m == n)
+    {
+      if (cover->count >= cover->limit)
+	{
+	  int limit = (cover->limit + 4) * 2;
+	  PANEL_SPAN *span = typeRealloc(PANEL_SPAN, (size_t) limit, cover->span);
+
+	  if (span == 0)
+	    {
+	      cover->span = 0;
+	      cover->count = cover->limit = 0;
+	      return FALSE;
+	    }
+	  cover->span = span;
+	  cover->limit = limit;
+	}
+      memmove(cover->span + n + 1,
+	      cover->span + n,
+	      sizeof(PANEL_SPAN) * (size_t) (cover->count - n));
+      cover->count++;
+    }
+  else if (m > n + 1)
+    {
+      memmove(cover->span + n + 1,
+	      cover->span + m,
+	      sizeof(PANEL_SPAN) * (size_t) (cover->count - m));
+      cover->count -= (m - n - 1);
+    }
+  cover->span[n].x1 = x1;
+  cover->span[n].x2 = x2;
+  return TRUE;
+}
+
+/*
+ * Find the nth piece of the columns a..b which is not covered.
+ */
+static bool
+visible_piece(PANEL_LINE * cover, int a, int b, int nth, int *x1, int *x2)
+{
+  int n;
+
+  for (n = 0; n < cover->count && a <= b; ++n)
+    {
+      if (cover->span[n].x2 < a)
+	continue;
+      if (cover->span[n].x1 > b)
+	break;
+      if (cover->span[n].x1 > a && nth-- == 0)
+	{
+	  *x1 = a;
+	  *x2 = cover->span[n].x1 - 1;
+	  return TRUE;
+	}
+      a = cover->span[n].x2 + 1;
+    }
+  if (a <= b && nth == 0)
+    {
+      *x1 = a;
+      *x2 = b;
+      return TRUE;
+    }
+  return FALSE;
+}
+
+#if USE_WIDEC_SUPPORT
+/*
+ * wnoutrefresh() widens the range it copies to whole multi-column characters,
+ * and blanks those in newscr which it overwrites in part, looking at the cells
+ * at the ends of the range.  If a line is split into pieces, or its covered
+ * part is skipped, those cells may differ from what a full refresh would find
+ * there, so a line whose touched columns have multi-column characters, either
+ * in the window or beneath it in newscr, must be copied in one piece.
+ */
+static bool
+wide_line(WINDOW *win, int y, WINDOW *scr, int dy, int dx)
+{
+  struct ldat *line = &(win->_line[y]);
+  struct ldat *nline = &(scr->_line[dy]);
+  int x;
+
+  for (x = line->firstchar; x <= line->lastchar; ++x)
+    {
+      if (WidecExt(line->text[x]) != 0)
+	return TRUE;
+      if (dx + x >= 0
+	  && dx + x <= scr->_maxx
+	  && WidecExt(nline->text[dx + x]) != 0)
+	return TRUE;
+    }
+  return FALSE;
+}
+#else
+#define wide_line(win, y, scr, dy, dx) FALSE
+#endif
+
+/*
+ * List the panels above the n'th panel of the stack which overlap it.
+ */
+static int
+find_above(struct panel_index *idx, int n)
+{
+  PANEL_EXTENT *ext = &(idx->extent[n]);
+  int found = list_above(idx, n,
+			 grid_cell(ext->y1, PANEL_GRID_ROWS, idx->rows),
+			 grid_cell(ext->y2, PANEL_GRID_ROWS, idx->rows),
+			 grid_cell(ext->x1, PANEL_GRID_COLS, idx->cols),
+			 grid_cell(ext->x2, PANEL_GRID_COLS, idx->cols));
+  int result = 0;
+  int k;
+
+  for (k = 0; k < found; ++k)
+    {
+      PANEL_EXTENT *ext2 = &(idx->extent[idx->above[k]]);
+
+      if (!(ext->y1 > ext2->y2 || ext->y2 < ext2->y1 ||
+	    ext->x1 > ext2->x2 || ext->x2 < ext2->x1))
+	idx->above[result++] = idx->above[k];
+    }
+  return result;
+}
+
+/*
+ * Find the spans of each line of the n'th panel which are covered by the
+ * panels above it.  Returns false if there is not enough memory.
+ */
+static bool
+find_covered(struct panel_index *idx, int n, int found)
+{
+  PANEL_EXTENT *ext = &(idx->extent[n]);
+  int height = ext->y2 - ext->y1 + 1;
+  int k, y;
+
+  if (height > idx->lines_limit)
+    {
+      PANEL_LINE *covered = typeCalloc(PANEL_LINE, (size_t) height);
+
+      if (covered == 0)
+	return FALSE;
+      if (idx->covered != 0)
+	{
+	  memcpy(covered, idx->covered,
+		 sizeof(PANEL_LINE) * (size_t) idx->lines_limit);
+	  free(idx->covered);
+	}
+      idx->covered = covered;
+      idx->lines_limit = height;
+    }
+  for (y = 0; y < height; ++y)
+    idx->covered[y].count = 0;
+
+  for (k = 0; k < found; ++k)
+    {
+      PANEL_EXTENT *ext2 = &(idx->extent[idx->above[k]]);
+      int y2 = (ext->y2 < ext2->y2) ? ext->y2 : ext2->y2;
+      int x1 = (ext->x1 > ext2->x1) ? ext->x1 : ext2->x1;
+      int x2 = (ext->x2 < ext2->x2) ? ext->x2 : ext2->x2;
+
+      for (y = (ext->y1 > ext2->y1) ? ext->y1 : ext2->y1; y <= y2; ++y)
+	{
+	  if (!cover_span(&(idx->covered[y - ext->y1]), x1, x2))
+	    return FALSE;
+	}
+    }
+  return TRUE;
+}
+
+/*
+ * Copy the n'th panel to newscr, omitting the cells covered by the panels
+ * above it.  wnoutrefresh() copies a single range of each line, so a panel
+ * whose lines are split by the panels above is copied in several passes, one
+ * piece of each line at a time.  Lines with multi-column characters are copied
+ * whole, in the first pass.  A panel which is covered entirely is not copied
+ * at all.
+ */
+static void
+refresh_panel(struct panel_index *idx, int n, WINDOW *scr)
+{
+  PANEL_EXTENT *ext = &(idx->extent[n]);
+  PANEL *pan = ext->pan;
+  WINDOW *win = pan->win;
+  int found = find_above(idx, n);
+  int x1 = (ext->x1 > 0) ? ext->x1 : 0;
+  int x2 = (ext->x2 < scr->_maxx) ? ext->x2 : scr->_maxx;
+  bool hidden = TRUE;
+  int pass, y;
+
+  if (found == 0 || !find_covered(idx, n, found))
+    {
+      Wnoutrefresh(pan);
+      return;
+    }
+
+  for (y = 0; y <= win->_maxy; ++y)
+    {
+      PANEL_LINE *cover = &(idx->covered[y]);
+      int dy = ext->y1 + y + win->_yoffset;
+      int a, b;
+
+      cover->first = win->_line[y].firstchar;
+      cover->last = win->_line[y].lastchar;
+      cover->whole = (cover->first != _NOCHANGE
+		      && dy >= 0
+		      && dy <= scr->_maxy
+		      && wide_line(win, y, scr, dy, ext->x1));
+      if (hidden
+	  && ext->y1 + y >= 0
+	  && ext->y1 + y <= scr->_maxy
+	  && (cover->whole || visible_piece(cover, x1, x2, 0, &a, &b)))
+	hidden = FALSE;
+    }
+
+  if (hidden && !win->_clear)
+    {
+      for (y = 0; y <= win->_maxy; ++y)
+	win->_line[y].firstchar = win->_line[y].lastchar = _NOCHANGE;
+      return;
+    }
+
+  for (pass = 0;; ++pass)
+    {
+      bool more = FALSE;
+
+      for (y = 0; y <= win->_maxy; ++y)
+	{
+	  PANEL_LINE *cover = &(idx->covered[y]);
+	  struct ldat *line = &(win->_line[y]);
+	  int a, b;
+
+	  if (cover->whole)
+	    {
+	      if (pass == 0)
+		{
+		  line->firstchar = (NCURSES_SIZE_T) cover->first;
+		  line->lastchar = (NCURSES_SIZE_T) cover->last;
+		}
+	      else
+		{
+		  line->firstchar = line->lastchar = _NOCHANGE;
+		}
+	    }
+	  else if (cover->first != _NOCHANGE
+		   && visible_piece(cover,
+				    ext->x1 + cover->first,
+				    ext->x1 + cover->last,
+				    pass, &a, &b))
+	    {
+	      line->firstchar = (NCURSES_SIZE_T) (a - ext->x1);
+	      line->lastchar = (NCURSES_SIZE_T) (b - ext->x1);
+	      more = TRUE;
+	    }
+	  else
+	    {
+	      line->firstchar = line->lastchar = _NOCHANGE;
+	    }
+	}
+      if (more || pass == 0)
+	Wnoutrefresh(pan);
+      if (!more)
+	break;
+    }
+}
+
+/*
+ * The index is freed when the last panel is deleted, or by delscreen.
+ */
+static void
+free_panel_index(struct panel_index *idx)
+{
+  if (idx != 0)
+    {
+      if (idx->covered != 0)
+	{
+	  int y;
+
+	  for (y = 0; y < idx->lines_limit; ++y)
+	    FreeIfNeeded(idx->covered[y].span);
+	  free(idx->covered);
+	}
+      FreeIfNeeded(idx->above);
+      FreeIfNeeded(idx->extent);
+      FreeIfNeeded(idx->first);
+      FreeIfNeeded(idx->cover);
+      free(idx);
+    }
+}
+
 NCURSES_EXPORT(void)
 NCURSES_SP_NAME(update_panels) (NCURSES_SP_DCL0)
 {
   PANEL *pan;
+  bool indexed = FALSE;
 
   T((T_CALLED("update_panels(%p)"), (void *)SP_PARM));
   dBug(("--> update_panels"));
@@ -51,18 +629,47 @@ NCURSES_SP_NAME(update_panels) (NCURSES_SP_DCL0)
     {
       GetScreenHook(SP_PARM);
 
-      pan = _nc_bottom_panel;
-      while (pan && pan->above)
+      if (_nc_panel_index == 0)
 	{
-	  PANEL_UPDATE(pan, pan->above);
-	  pan = pan->above;
+	  _nc_panel_index = typeCalloc(struct panel_index, 1);
+	  _nc_panel_free_index = free_panel_index;
 	}
 
-      pan = _nc_bottom_panel;
-      while (pan)
+      if (_nc_panel_index != 0
+	  && (index_is_current(_nc_panel_index, _nc_bottom_panel)
+	      || build_index(_nc_panel_index, _nc_bottom_panel)))
+	{
+	  int n;
+
+	  for (n = 0; n + 1 < _nc_panel_index->count; ++n)
+	    touch_above(_nc_panel_index, n);
+	  indexed = TRUE;
+	}
+      else
+	{
+	  pan = _nc_bottom_panel;
+	  while (pan && pan->above)
+	    {
+	      PANEL_UPDATE(pan, pan->above);
+	      pan = pan->above;
+	    }
+	}
+
+      if (indexed)
+	{
+	  int n;
+
+	  for (n = 0; n < _nc_panel_index->count; ++n)
+	    refresh_panel(_nc_panel_index, n, NewScreen(SP_PARM));
+	}
+      else
 	{
-	  Wnoutrefresh(pan);
-	  pan = pan->above;
+	  pan = _nc_bottom_panel;
+	  while (pan)
+	    {
+	      Wnoutrefresh(pan);
+	      pan = pan->above;
+	    }
 	}
     }
 
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2014,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -95,6 +95,8 @@ struct screen;              /* forward declaration */
 #define _nc_stdscr_pseudo_panel ((ph)->stdscr_pseudo_panel)
 #define _nc_top_panel           ((ph)->top_panel)
 #define _nc_bottom_panel        ((ph)->bottom_panel)
+#define _nc_panel_index         ((ph)->panel_index)
+#define _nc_panel_free_index    ((ph)->free_index)
 
 #else	/* !NCURSES_SP_FUNCS */
 
@@ -106,6 +108,8 @@ struct screen;              /* forward declaration */
 #define _nc_stdscr_pseudo_panel _nc_panelhook()->stdscr_pseudo_panel
 #define _nc_top_panel           _nc_panelhook()->top_panel
 #define _nc_bottom_panel        _nc_panelhook()->bottom_panel
+#define _nc_panel_index         _nc_panelhook()->panel_index
+#define _nc_panel_free_index    _nc_panelhook()->free_index
 
 #endif	/* NCURSES_SP_FUNCS */
 
@@ -147,6 +151,23 @@ struct screen;              /* forward declaration */
    assert((ix1<=ix2) && (iy1<=iy2))
 
 
+/*+-------------------------------------------------------------------------
+	If pan2 overlaps pan, touch the part of pan2 which lies on the lines
+	that are touched in pan.
+---------------------------------------------------------------------------*/
+#define PANEL_TOUCH(pan,pan2)\
+{  if ((pan2 != pan) && PANELS_OVERLAPPED(pan,pan2)) {\
+     int y, ix1, ix2, iy1, iy2;\
+     COMPUTE_INTERSECTION(pan, pan2, ix1, ix2, iy1, iy2);\
+     for(y = iy1; y <= iy2; y++) {\
+       if (is_linetouched(pan->win,y - PSTARTY(pan))) {\
+         struct ldat* line = &(pan2->win->_line[y - PSTARTY(pan2)]);\
+         CHANGED_RANGE(line, ix1 - PSTARTX(pan2), ix2 - PSTARTX(pan2));\
+       }\
+     }\
+   }\
+}
+
 /*+-------------------------------------------------------------------------
 	Walk through the panel stack starting at the given location and
         check for intersections; overlapping panels are "touched", so they
@@ -157,20 +178,70 @@ struct screen;              /* forward declaration */
 #define PANEL_UPDATE(pan,panstart)\
 {  PANEL* pan2 = ((panstart) ? (panstart) : _nc_bottom_panel);\
    while(pan2 && pan2->win) {\
-      if ((pan2 != pan) && PANELS_OVERLAPPED(pan,pan2)) {\
-        int y, ix1, ix2, iy1, iy2;\
-        COMPUTE_INTERSECTION(pan, pan2, ix1, ix2, iy1, iy2);\
-	for(y = iy1; y <= iy2; y++) {\
-	  if (is_linetouched(pan->win,y - PSTARTY(pan))) {\
-            struct ldat* line = &(pan2->win->_line[y - PSTARTY(pan2)]);\
-            CHANGED_RANGE(line, ix1 - PSTARTX(pan2), ix2 - PSTARTX(pan2));\
-          }\
-	}\
-      }\
+      PANEL_TOUCH(pan,pan2);\
       pan2 = pan2->above;\
    }\
 }
 
+/*+-------------------------------------------------------------------------
+	update_panels keeps an index of the panels in the stack, bottom first,
+	with their extents, and a grid of cells each listing the panels which
+	cover it.  The index is rebuilt when the stack changes, or the size or
+	position of a panel.  When a panel is refreshed, it also holds the
+	spans of each of its lines which are covered by the panels above.
+---------------------------------------------------------------------------*/
+#define PANEL_GRID_ROWS	4	/* size of a cell in the grid */
+#define PANEL_GRID_COLS	16
+
+typedef struct {
+   PANEL *pan;
+   int y1, x1, y2, x2;		/* extent of the panel in the index */
+   int seen;			/* stamp of the last search which found it */
+} PANEL_EXTENT;
+
+typedef struct {
+   int x1, x2;
+} PANEL_SPAN;
+
+typedef struct {
+   int count;			/* sorted, disjoint spans in span[] */
+   int limit;
+   PANEL_SPAN *span;
+   int first;			/* touched columns of the line */
+   int last;
+   bool whole;			/* copy the touched columns in one piece */
+} PANEL_LINE;
+
+struct panel_index {
+   bool stale;			/* set when the stack changes */
+   int count;			/* number of panels in extent[] */
+   int extent_limit;
+   PANEL_EXTENT *extent;
+   int rows;			/* size of the grid, in cells */
+   int cols;
+   int first_limit;
+   int *first;			/* start of each cell's list in cover[] */
+   int cover_limit;
+   int *cover;			/* panels (in extent[]) covering each cell */
+   int stamp;			/* counts searches of the grid */
+   int above_limit;
+   int *above;			/* panels found above a given panel */
+   int lines_limit;
+   PANEL_LINE *covered;		/* covered columns of each of its lines */
+};
+
+#define PANEL_INDEX_STALE() \
+{  if (_nc_panel_index != 0) \
+     _nc_panel_index->stale = TRUE;\
+}
+
+#define PANEL_INDEX_FREE() \
+{  if (_nc_panel_index != 0) {\
+     _nc_panel_free_index(_nc_panel_index);\
+     _nc_panel_index = 0;\
+   }\
+}
+
 /*+-------------------------------------------------------------------------
 	Remove panel from stack.
 ---------------------------------------------------------------------------*/
@@ -197,6 +268,7 @@ struct screen;              /* forward declaration */
     Touchpan(pan);\
     PANEL_UPDATE(pan,(PANEL*)0);\
     PANEL_UNLINK(pan,err);\
+    PANEL_INDEX_STALE();\
   } \
   else {\
       err = err_if_unlinked;\
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2016,2017 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2017,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -42,6 +42,13 @@
 
 #include <dump_entry.h>
 
+#if HAVE_WORKING_FORK
+#include <sys/wait.h>
+#define USE_CMP_JOBS 1
+#else
+#define USE_CMP_JOBS 0
+#endif
+
 MODULE_ID("$Id: infocmp.c,v 1.143 2017/04/05 09:27:51 tom Exp $")
 
 #define MAX_STRING	1024	/* maximum formatted string */
@@ -82,6 +89,9 @@ static int compare;
 #define C_NAND		3	/* list capabilities in neither terminal */
 #define C_USEALL	4	/* generate relative use-form entry */
 static bool ignorepads;		/* ignore pad prefixes when diffing */
+#if USE_CMP_JOBS
+static int cmp_jobs = 1;	/* number of processes for -F comparison */
+#endif
 
 #if NO_LEAKS
 
@@ -1002,6 +1012,307 @@ analyze_string(const char *name, const char *cap, TERMTYPE2 *tp)
  *
  ***************************************************************************/
 
+static void
+add_crosslink(ENTRY * qp, ENTRY * rp)
+{
+    if (qp->ncrosslinks < MAX_CROSSLINKS)
+	qp->crosslinks[qp->ncrosslinks] = rp;
+    qp->ncrosslinks++;
+
+    if (rp->ncrosslinks < MAX_CROSSLINKS)
+	rp->crosslinks[rp->ncrosslinks] = qp;
+    rp->ncrosslinks++;
+}
+
+/*
+ * Crosslink the entries of the two lists which share a name, in the same
+ * order as comparing every pair of entries would.  The names of the entries
+ * in the second list are indexed, so that each entry of the first is checked
+ * with _nc_entry_match() only against the entries which have a name (or
+ * description) with the same hash.
+ */
+static void
+match_entries(ENTRY * head1, ENTRY * head2)
+{
+    NAME_NODE **table;
+    NAME_NODE *nodes;
+    ENTRY **list;
+    unsigned *found;
+    unsigned *seen;
+    unsigned count = 0;
+    unsigned fields = 0;
+    unsigned used = 0;
+    unsigned size;
+    unsigned serial = 0;
+    unsigned n;
+    ENTRY *qp, *rp;
+
+    for (rp = head2; rp; rp = rp->next) {
+	const char *t;
+
+	++count;
+	++fields;
+	for (t = rp->tterm.term_names; *t != '\0'; ++t) {
+	    if (*t == '|')
+		++fields;
+	}
+    }
+    if (count == 0)
+	return;
+
+    for (size = 64; size < 2 * fields; size <<= 1) {
+	;
+    }
+    table = typeCalloc(NAME_NODE *, size);
+    nodes = typeMalloc(NAME_NODE, fields);
+    list = typeMalloc(ENTRY *, count);
+    found = typeMalloc(unsigned, count);
+    seen = typeCalloc(unsigned, count);
+    if (table == 0 || nodes == 0 || list == 0 || found == 0 || seen == 0)
+	failed("match_entries");
+
+    n = 0;
+    for (rp = head2; rp; rp = rp->next)
+	list[n++] = rp;
+
+    for (n = 0; n < count; ++n) {
+	used += _nc_index_fields(table, size, nodes + used,
+				 list[n]->tterm.term_names, n);
+    }
+
+    for (qp = head1; qp; qp = qp->next) {
+	const char *name = qp->tterm.term_names;
+	unsigned result = 0;
+
+	++serial;
+	for (;;) {
+	    size_t length = _nc_field_length(name);
+	    unsigned hashed = _nc_hash_name(name, length);
+	    NAME_NODE *node;
+
+	    for (node = table[hashed & (size - 1)]; node; node = node->next) {
+		if (node->hashed == hashed
+		    && seen[node->order] != serial) {
+		    seen[node->order] = serial;
+		    if (_nc_entry_match(qp->tterm.term_names,
+					list[node->order]->tterm.term_names))
+			found[result++] = node->order;
+		}
+	    }
+	    if (name[length] == '\0')
+		break;
+	    name += length + 1;
+	}
+	if (result > 1)
+	    qsort(found, (size_t) result, sizeof(unsigned), _nc_compare_order);
+	for (n = 0; n < result; ++n)
+	    add_crosslink(qp, list[found[n]]);
+    }
+
+    free(table);
+    free(nodes);
+    free(list);
+    free(found);
+    free(seen);
+}
+
+static void
+show_equivalent(ENTRY ** list, int first, int last)
+{
+    int n;
+
+    for (n = first; n < last; ++n) {
+	ENTRY *qp = list[n];
+	ENTRY *rp = qp->crosslinks[0];
+
+	repair_acsc(&qp->tterm);
+	repair_acsc(&rp->tterm);
+#if NCURSES_XNAMES
+	_nc_align_termtype(&qp->tterm, &rp->tterm);
+#endif
+	if (entryeq(&qp->tterm, &rp->tterm) && useeq(qp, rp)) {
+	    char name1[NAMESIZE], name2[NAMESIZE];
+
+	    (void) canonical_name(qp->tterm.term_names, name1);
+	    (void) canonical_name(rp->tterm.term_names, name2);
+
+	    (void) printf("%s = %s\n", name1, name2);
+	}
+    }
+}
+
+static void
+show_differing(ENTRY ** list, int first, int last)
+{
+    int n;
+
+    termcount = 2;
+    for (n = first; n < last; ++n) {
+	ENTRY *qp = list[n];
+	ENTRY *rp = qp->crosslinks[0];
+
+#if NCURSES_XNAMES
+	/* sorry - we have to do this on each pass */
+	_nc_align_termtype(&qp->tterm, &rp->tterm);
+#endif
+	if (!(entryeq(&qp->tterm, &rp->tterm) && useeq(qp, rp))) {
+	    char name1[NAMESIZE], name2[NAMESIZE];
+	    char *names[3];
+
+	    names[0] = name1;
+	    names[1] = name2;
+	    names[2] = 0;
+
+	    entries[0] = *qp;
+	    entries[1] = *rp;
+
+	    (void) canonical_name(qp->tterm.term_names, name1);
+	    (void) canonical_name(rp->tterm.term_names, name2);
+
+	    switch (compare) {
+	    case C_DIFFERENCE:
+		show_comparing(names);
+		compare_entry(compare_predicate, &entries->tterm, quiet);
+		break;
+
+	    case C_COMMON:
+		show_comparing(names);
+		compare_entry(compare_predicate, &entries->tterm, quiet);
+		break;
+
+	    case C_NAND:
+		show_comparing(names);
+		compare_entry(compare_predicate, &entries->tterm, quiet);
+		break;
+
+	    }
+	}
+    }
+}
+
+#if USE_CMP_JOBS
+static void
+copy_output(FILE *fp)
+{
+    int ch;
+
+    rewind(fp);
+    while ((ch = fgetc(fp)) != EOF)
+	putchar(ch);
+    fclose(fp);
+}
+
+/*
+ * Split the pairs into contiguous parts, and fork a process to compare each
+ * part.  Each process writes the two sections of its report to temporary
+ * files, which we copy to the standard output in order, so the report is the
+ * same as if one process had made it.
+ */
+static void
+compare_parallel(ENTRY ** list, int count, int jobs)
+{
+    FILE **equal;
+    FILE **differ;
+    pid_t *pids;
+    bool ok = TRUE;
+    int n;
+
+    if (jobs > count)
+	jobs = count;
+
+    equal = typeCalloc(FILE *, (size_t) jobs);
+    differ = typeCalloc(FILE *, (size_t) jobs);
+    pids = typeCalloc(pid_t, (size_t) jobs);
+    if (equal == 0 || differ == 0 || pids == 0)
+	failed("compare_parallel");
+
+    fflush(stdout);
+    fflush(stderr);
+    for (n = 0; n < jobs; ++n) {
+	if ((equal[n] = tmpfile()) == 0
+	    || (differ[n] = tmpfile()) == 0)
+	    failed("tmpfile");
+	if ((pids[n] = fork()) < 0)
+	    failed("fork");
+	if (pids[n] == 0) {
+	    int first = (int) (((long) count * n) / jobs);
+	    int last = (int) (((long) count * (n + 1)) / jobs);
+
+	    if (dup2(fileno(equal[n]), STDOUT_FILENO) < 0)
+		_exit(EXIT_FAILURE);
+	    show_equivalent(list, first, last);
+	    fflush(stdout);
+	    if (dup2(fileno(differ[n]), STDOUT_FILENO) < 0)
+		_exit(EXIT_FAILURE);
+	    show_differing(list, first, last);
+	    fflush(stdout);
+	    _exit(EXIT_SUCCESS);
+	}
+    }
+
+    for (n = 0; n < jobs; ++n) {
+	int status = 0;
+
+	if (waitpid(pids[n], &status, 0) < 0
+	    || !WIFEXITED(status)
+	    || WEXITSTATUS(status) != EXIT_SUCCESS)
+	    ok = FALSE;
+    }
+    if (!ok) {
+	fprintf(stderr, "%s: process comparing entries failed\n", _nc_progname);
+	ExitProgram(EXIT_FAILURE);
+    }
+
+    (void) printf("The following entries are equivalent:\n");
+    for (n = 0; n < jobs; ++n)
+	copy_output(equal[n]);
+    (void) printf("Differing entries:\n");
+    for (n = 0; n < jobs; ++n)
+	copy_output(differ[n]);
+
+    free(equal);
+    free(differ);
+    free(pids);
+}
+#endif
+
+/*
+ * Report the entries of the first list which match exactly one entry of the
+ * second, first those which are equivalent, then the differences.
+ */
+static void
+compare_entries(ENTRY * head)
+{
+    ENTRY *qp;
+    ENTRY **list;
+    int count = 0;
+
+    for (qp = head; qp; qp = qp->next) {
+	if (qp->ncrosslinks == 1)
+	    ++count;
+    }
+    if ((list = typeMalloc(ENTRY *, (size_t) (count + 1))) == 0)
+	failed("compare_entries");
+    count = 0;
+    for (qp = head; qp; qp = qp->next) {
+	if (qp->ncrosslinks == 1)
+	    list[count++] = qp;
+    }
+
+#if USE_CMP_JOBS
+    if (cmp_jobs > 1 && count > 1) {
+	compare_parallel(list, count, cmp_jobs);
+    } else
+#endif
+    {
+	(void) printf("The following entries are equivalent:\n");
+	show_equivalent(list, 0, count);
+	(void) printf("Differing entries:\n");
+	show_differing(list, 0, count);
+    }
+    free(list);
+}
+
 static void
 file_comparison(int argc, char *argv[])
 {
@@ -1055,19 +1366,7 @@ file_comparison(int argc, char *argv[])
     if (itrace)
 	(void) fprintf(stderr, "Entries are now in core...\n");
 
-    /* The entry-matching loop. Sigh, this is intrinsically quadratic. */
-    for (qp = heads[0]; qp; qp = qp->next) {
-	for (rp = heads[1]; rp; rp = rp->next)
-	    if (_nc_entry_match(qp->tterm.term_names, rp->tterm.term_names)) {
-		if (qp->ncrosslinks < MAX_CROSSLINKS)
-		    qp->crosslinks[qp->ncrosslinks] = rp;
-		qp->ncrosslinks++;
-
-		if (rp->ncrosslinks < MAX_CROSSLINKS)
-		    rp->crosslinks[rp->ncrosslinks] = qp;
-		rp->ncrosslinks++;
-	    }
-    }
+    match_entries(heads[0], heads[1]);
 
     /* now we have two circular lists with crosslinks */
     if (itrace)
@@ -1115,71 +1414,7 @@ file_comparison(int argc, char *argv[])
 	    (void) printf("\t%s\n",
 			  _nc_first_name(rp->tterm.term_names));
 
-    (void) printf("The following entries are equivalent:\n");
-    for (qp = heads[0]; qp; qp = qp->next) {
-	if (qp->ncrosslinks == 1) {
-	    rp = qp->crosslinks[0];
-
-	    repair_acsc(&qp->tterm);
-	    repair_acsc(&rp->tterm);
-#if NCURSES_XNAMES
-	    _nc_align_termtype(&qp->tterm, &rp->tterm);
-#endif
-	    if (entryeq(&qp->tterm, &rp->tterm) && useeq(qp, rp)) {
-		char name1[NAMESIZE], name2[NAMESIZE];
-
-		(void) canonical_name(qp->tterm.term_names, name1);
-		(void) canonical_name(rp->tterm.term_names, name2);
-
-		(void) printf("%s = %s\n", name1, name2);
-	    }
-	}
-    }
-
-    (void) printf("Differing entries:\n");
-    termcount = 2;
-    for (qp = heads[0]; qp; qp = qp->next) {
-
-	if (qp->ncrosslinks == 1) {
-	    rp = qp->crosslinks[0];
-#if NCURSES_XNAMES
-	    /* sorry - we have to do this on each pass */
-	    _nc_align_termtype(&qp->tterm, &rp->tterm);
-#endif
-	    if (!(entryeq(&qp->tterm, &rp->tterm) && useeq(qp, rp))) {
-		char name1[NAMESIZE], name2[NAMESIZE];
-		char *names[3];
-
-		names[0] = name1;
-		names[1] = name2;
-		names[2] = 0;
-
-		entries[0] = *qp;
-		entries[1] = *rp;
-
-		(void) canonical_name(qp->tterm.term_names, name1);
-		(void) canonical_name(rp->tterm.term_names, name2);
-
-		switch (compare) {
-		case C_DIFFERENCE:
-		    show_comparing(names);
-		    compare_entry(compare_predicate, &entries->tterm, quiet);
-		    break;
-
-		case C_COMMON:
-		    show_comparing(names);
-		    compare_entry(compare_predicate, &entries->tterm, quiet);
-		    break;
-
-		case C_NAND:
-		    show_comparing(names);
-		    compare_entry(compare_predicate, &entries->tterm, quiet);
-		    break;
-
-		}
-	    }
-	}
-    }
+    compare_entries(heads[0]);
 }
 
 static void
@@ -1220,6 +1455,9 @@ usage(void)
 	,"  -f    with -1, format complex strings"
 	,"  -g    format %'char' to %{number}"
 	,"  -i    analyze initialization/reset"
+#if USE_CMP_JOBS
+	,"  -j number  with -F, processes to use"
+#endif
 	,"  -l    output terminfo names"
 	,"  -n    list capabilities in neither"
 	,"  -p    ignore padding specifiers"
@@ -1556,7 +1794,7 @@ main(int argc, char *argv[])
 
     while ((c = getopt(argc,
 		       argv,
-		       "01A:aB:CcDdEeFfGgIiKLlnpQ:qR:rs:TtUuVv:Ww:x")) != -1) {
+		       "01A:aB:CcDdEeFfGgIij:KLlnpQ:qR:rs:TtUuVv:Ww:x")) != -1) {
 	switch (c) {
 	case '0':
 	    mwidth = 65535;
@@ -1639,6 +1877,14 @@ main(int argc, char *argv[])
 	    init_analyze = TRUE;
 	    break;
 
+#if USE_CMP_JOBS
+	case 'j':
+	    cmp_jobs = optarg_to_number();
+	    if (cmp_jobs < 1)
+		cmp_jobs = 1;
+	    break;
+#endif
+
 	case 'L':
 	    outform = F_VARIABLE;
 	    if (sortmode == S_DEFAULT)
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2018,2019 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2019,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -48,6 +48,13 @@
 #include <parametrized.h>
 #include <transform.h>
 
+#if HAVE_WORKING_FORK && !USE_HASHED_DB
+#include <sys/wait.h>
+#define USE_TIC_JOBS 1
+#else
+#define USE_TIC_JOBS 0
+#endif
+
 MODULE_ID("$Id: tic.c,v 1.281 2019/11/09 18:51:36 tom Exp $")
 
 #define STDIN_NAME "<stdin>"
@@ -62,6 +69,7 @@ static bool showsummary = FALSE;
 static unsigned debug_level;
 static char **namelst = 0;
 static const char *to_remove;
+static int tic_jobs = 1;	/* number of processes writing entries */
 
 #if NCURSES_XNAMES
 static bool using_extensions = FALSE;
@@ -72,6 +80,7 @@ static void check_termtype(TERMTYPE2 *tt, bool);
 
 static const char usage_string[] = "\
 [-e names] \
+[-j jobs] \
 [-o dir] \
 [-R name] \
 [-v[n]] \
@@ -87,6 +96,7 @@ f\
 G\
 g\
 I\
+i\
 K\
 L\
 N\
@@ -161,6 +171,8 @@ usage(void)
 	DATA("  -G         format %{number} to %'char'")
 	DATA("  -g         format %'char' to %{number}")
 	DATA("  -I         translate entries to terminfo source form")
+	DATA("  -i         write only entries which differ from the last compile")
+	DATA("  -j<jobs>   write compiled entries using this many processes")
 	DATA("  -K         translate entries to termcap source form with BSD syntax")
 	DATA("  -L         translate entries to full terminfo source form")
 	DATA("  -N         disable smart defaults for source translation")
@@ -198,7 +210,7 @@ usage(void)
 #define S_QUOTE '\''
 
 static void
-write_it(ENTRY * ep)
+compact_strings(ENTRY * ep)
 {
     unsigned n;
     int ch;
@@ -242,12 +254,272 @@ write_it(ENTRY * ep)
 		_nc_STRCPY(s, result, strlen(s) + 1);
 	}
     }
+}
 
+static void
+write_it(ENTRY * ep)
+{
+    compact_strings(ep);
     _nc_set_type(_nc_first_name(ep->tterm.term_names));
     _nc_curr_line = (int) ep->startline;
     _nc_write_entry(&ep->tterm);
 }
 
+#if NCURSES_USE_DATABASE && !USE_HASHED_DB
+/*
+ * Incremental compiling.  A manifest in the top of the database records for
+ * each entry its names, a hash of its compiled form, and the size and
+ * modification time of the file which was written.  When all of those match,
+ * the entry need not be written again.  Since use= references are merged
+ * into the compiled form, a change to an entry's parents changes its hash.
+ */
+#define MANIFEST_NAME ".tic-manifest"
+#define MANIFEST_HEAD "# tic manifest 1"
+#define HASH_SIZE     20
+
+#if MIXEDCASE_FILENAMES
+#define LEAF_FMT "%c"
+#else
+#define LEAF_FMT "%02x"
+#endif
+
+typedef struct {
+    char *names;		/* the entry's names, as in term_names */
+    char hash[HASH_SIZE];	/* hash of its compiled form */
+    unsigned long size;		/* size of the file when written */
+    long mtime;			/* modification time of the file */
+    bool updated;		/* the old record was replaced */
+    bool written;		/* size/mtime are taken after writing */
+} MANIFEST;
+
+static bool incremental = FALSE;
+static int unchanged;		/* number of entries not rewritten */
+static int hashed;		/* number of entries hashed */
+static MANIFEST *old_list;
+static size_t old_count;
+static MANIFEST *new_list;
+static size_t new_count;
+static size_t new_limit;
+
+static size_t
+name_length(const char *names)
+{
+    const char *bar = strchr(names, '|');
+    return (bar != 0) ? (size_t) (bar - names) : strlen(names);
+}
+
+static int
+compare_manifest(const void *a, const void *b)
+{
+    const char *p = ((const MANIFEST *) a)->names;
+    const char *q = ((const MANIFEST *) b)->names;
+    size_t lp = name_length(p);
+    size_t lq = name_length(q);
+    int rc = strncmp(p, q, (lp < lq) ? lp : lq);
+
+    if (rc == 0)
+	rc = (lp > lq) - (lp < lq);
+    return rc;
+}
+
+static void
+entry_path(char *dst, const char *names)
+{
+    _nc_SPRINTF(dst, _nc_SLIMIT(PATH_MAX) LEAF_FMT "/%.*s",
+		UChar(*names),
+		(int) name_length(names), names);
+}
+
+static void
+hash_object(TERMTYPE2 *tp, char *dst)
+{
+    char buffer[MAX_ENTRY_SIZE];
+    unsigned offset = 0;
+    unsigned long h1 = 2166136261UL;
+    unsigned long h2 = 5381;
+    unsigned n;
+
+    if (_nc_write_object(tp, buffer, &offset, sizeof(buffer)) == ERR) {
+	*dst = '\0';
+	return;
+    }
+    ++hashed;			/* _nc_tic_written() counts this object */
+    for (n = 0; n < offset; ++n) {
+	h1 = ((h1 ^ UChar(buffer[n])) * 16777619UL) & 0xffffffffUL;
+	h2 = ((h2 * 33) + UChar(buffer[n])) & 0xffffffffUL;
+    }
+    _nc_SPRINTF(dst, _nc_SLIMIT(HASH_SIZE) "%08lx%08lx", h1, h2);
+}
+
+static void
+load_manifest(void)
+{
+    FILE *fp;
+    char buffer[MAX_TERMINFO_LENGTH + 80];
+    size_t limit = 0;
+
+    if ((fp = fopen(MANIFEST_NAME, "r")) == 0)
+	return;
+    if (fgets(buffer, (int) sizeof(buffer), fp) == 0
+	|| strncmp(buffer, MANIFEST_HEAD, sizeof(MANIFEST_HEAD) - 1)) {
+	fclose(fp);
+	return;
+    }
+    while (fgets(buffer, (int) sizeof(buffer), fp) != 0) {
+	MANIFEST item;
+	char *names;
+	int skip = 0;
+
+	memset(&item, 0, sizeof(item));
+	buffer[strcspn(buffer, "\n")] = '\0';
+	if (sscanf(buffer, "%19s %lu %ld %n",
+		   item.hash, &item.size, &item.mtime, &skip) < 3
+	    || skip == 0
+	    || *(names = buffer + skip) == '\0') {
+	    continue;
+	}
+	if (old_count >= limit) {
+	    limit = (limit * 2) + 100;
+	    old_list = typeRealloc(MANIFEST, limit, old_list);
+	    if (old_list == 0)
+		failed("load_manifest");
+	}
+	item.names = strdup(names);
+	if (item.names == 0)
+	    failed("load_manifest");
+	old_list[old_count++] = item;
+    }
+    fclose(fp);
+    if (old_count > 1)
+	qsort(old_list, old_count, sizeof(MANIFEST), compare_manifest);
+}
+
+static MANIFEST *
+add_manifest(const char *names)
+{
+    MANIFEST *result;
+
+    if (new_count >= new_limit) {
+	new_limit = (new_limit * 2) + 100;
+	new_list = typeRealloc(MANIFEST, new_limit, new_list);
+	if (new_list == 0)
+	    failed("add_manifest");
+    }
+    result = &new_list[new_count++];
+    memset(result, 0, sizeof(*result));
+    if ((result->names = strdup(names)) == 0)
+	failed("add_manifest");
+    return result;
+}
+
+/*
+ * Return true if the entry must be written, i.e., its compiled form or names
+ * differ from those recorded in the manifest, or its file has been changed.
+ */
+static bool
+check_manifest(ENTRY * ep)
+{
+    static bool loaded = FALSE;
+    TERMTYPE2 *tp = &(ep->tterm);
+    MANIFEST key;
+    MANIFEST *old;
+    MANIFEST *item;
+    bool result = TRUE;
+
+    if (!loaded) {
+	load_manifest();
+	loaded = TRUE;
+    }
+
+    compact_strings(ep);
+    item = add_manifest(tp->term_names);
+    hash_object(tp, item->hash);
+
+    key.names = tp->term_names;
+    old = ((old_count != 0)
+	   ? (MANIFEST *) bsearch(&key, old_list, old_count,
+				  sizeof(MANIFEST), compare_manifest)
+	   : 0);
+    if (old != 0) {
+	char path[PATH_MAX];
+	struct stat sb;
+
+	old->updated = TRUE;
+	entry_path(path, tp->term_names);
+	if (item->hash[0] != '\0'
+	    && !strcmp(old->hash, item->hash)
+	    && !strcmp(old->names, tp->term_names)
+	    && stat(path, &sb) == 0
+	    && (unsigned long) sb.st_size == old->size
+	    && (long) sb.st_mtime == old->mtime) {
+	    item->size = old->size;
+	    item->mtime = old->mtime;
+	    ++unchanged;
+	    result = FALSE;
+	}
+    }
+    item->written = result;
+    return result;
+}
+
+/*
+ * Write the manifest, keeping the records of entries which were not compiled
+ * in this run.  The size and modification time of the files which were
+ * written are known only now, since they may have been written by other
+ * processes.
+ */
+static void
+save_manifest(void)
+{
+    static const char temp_name[] = MANIFEST_NAME ".tmp";
+    FILE *fp;
+    size_t n;
+
+    if ((fp = fopen(temp_name, "w")) == 0) {
+	perror(temp_name);
+	return;
+    }
+    fprintf(fp, "%s\n", MANIFEST_HEAD);
+    for (n = 0; n < old_count; ++n) {
+	MANIFEST *item = &old_list[n];
+
+	if (!item->updated)
+	    fprintf(fp, "%s %lu %ld %s\n",
+		    item->hash, item->size, item->mtime, item->names);
+	free(item->names);
+    }
+    for (n = 0; n < new_count; ++n) {
+	MANIFEST *item = &new_list[n];
+
+	if (item->written) {
+	    char path[PATH_MAX];
+	    struct stat sb;
+
+	    entry_path(path, item->names);
+	    if (item->hash[0] == '\0' || stat(path, &sb) != 0)
+		continue;
+	    item->size = (unsigned long) sb.st_size;
+	    item->mtime = (long) sb.st_mtime;
+	}
+	fprintf(fp, "%s %lu %ld %s\n",
+		item->hash, item->size, item->mtime, item->names);
+    }
+    for (n = 0; n < new_count; ++n)
+	free(new_list[n].names);
+    free(old_list);
+    free(new_list);
+    old_list = new_list = 0;
+    old_count = new_count = new_limit = 0;
+
+    if (fclose(fp) != 0 || rename(temp_name, MANIFEST_NAME) != 0)
+	perror(MANIFEST_NAME);
+}
+
+#define must_write(ep) (!incremental || check_manifest(ep))
+#else
+#define must_write(ep) TRUE
+#endif
+
 static bool
 immedhook(ENTRY * ep GCC_UNUSED)
 /* write out entries with no use capabilities immediately to save storage */
@@ -289,7 +561,8 @@ immedhook(ENTRY * ep GCC_UNUSED)
     if (ep->nuses == 0) {
 	int oldline = _nc_curr_line;
 
-	write_it(ep);
+	if (must_write(ep))
+	    write_it(ep);
 	_nc_curr_line = oldline;
 	free(ep->tterm.str_table);
 	return (TRUE);
@@ -676,6 +949,113 @@ add_digit(int *target, int source)
     *target = (*target * 10) + (source - '0');
 }
 
+#if USE_TIC_JOBS
+/*
+ * Once use-resolution is done, the entries are independent.  Split the list
+ * into contiguous parts, and fork a process to write each part.  Each process
+ * logs its messages to a temporary file, which we copy to the standard error
+ * in the order of the list, so the messages are the same as if the entries
+ * had been written by one process.  Return the number of entries written.
+ */
+static int
+write_parallel(int jobs)
+{
+    ENTRY *qp;
+    ENTRY **list;
+    FILE **logs;
+    pid_t *pids;
+    int count = 0;
+    int written = 0;
+    bool ok = TRUE;
+    int failed_at = -1;
+    int n, k;
+
+    for_entry_list(qp) {
+	if (matches(namelst, qp->tterm.term_names))
+	    ++count;
+    }
+    if (count == 0)
+	return 0;
+
+    list = typeMalloc(ENTRY *, (size_t) count);
+    if (list == 0)
+	failed("write_parallel");
+
+    count = 0;
+    for_entry_list(qp) {
+	if (matches(namelst, qp->tterm.term_names) && must_write(qp))
+	    list[count++] = qp;
+    }
+    if (count == 0) {
+	free(list);
+	return 0;
+    }
+    if (jobs > count)
+	jobs = count;
+
+    logs = typeCalloc(FILE *, (size_t) jobs);
+    pids = typeCalloc(pid_t, (size_t) jobs);
+    if (logs == 0 || pids == 0)
+	failed("write_parallel");
+
+    /* create the directories, and update their indices, only once */
+    for (k = 0; k < count; ++k)
+	_nc_write_prepare(&list[k]->tterm);
+
+    fflush(stdout);
+    fflush(stderr);
+    for (n = 0; n < jobs; ++n) {
+	if ((logs[n] = tmpfile()) == 0)
+	    failed("tmpfile");
+	if ((pids[n] = fork()) < 0)
+	    failed("fork");
+	if (pids[n] == 0) {
+	    int last = (int) (((long) count * (n + 1)) / jobs);
+
+	    if (dup2(fileno(logs[n]), STDERR_FILENO) < 0)
+		_exit(EXIT_FAILURE);
+	    for (k = (int) (((long) count * n) / jobs); k < last; ++k)
+		write_it(list[k]);
+	    fflush(stdout);
+	    _exit(EXIT_SUCCESS);
+	}
+    }
+
+    for (n = 0; n < jobs; ++n) {
+	int status = 0;
+	int ch;
+
+	if (waitpid(pids[n], &status, 0) < 0
+	    || !WIFEXITED(status)
+	    || WEXITSTATUS(status) != EXIT_SUCCESS) {
+	    if (ok) {
+		ok = FALSE;
+		failed_at = n;
+	    }
+	} else if (ok) {
+	    written += (int) ((((long) count * (n + 1)) / jobs)
+			      - (((long) count * n) / jobs));
+	}
+	/* a single process would have stopped at the first failure */
+	if (ok || failed_at == n) {
+	    rewind(logs[n]);
+	    while ((ch = fgetc(logs[n])) != EOF)
+		fputc(ch, stderr);
+	}
+	fclose(logs[n]);
+    }
+
+    free(list);
+    free(logs);
+    free(pids);
+    if (!ok) {
+	fprintf(stderr, "%s: process writing entries failed\n", _nc_progname);
+	ExitProgram(EXIT_FAILURE);
+    }
+    return written;
+}
+#endif
+
 int
 main(int argc, char *argv[])
 {
@@ -706,6 +1086,7 @@ main(int argc, char *argv[])
     int quickdump = 0;
     bool quiet = FALSE;
     bool wrap_strings = FALSE;
+    int parallel_written = 0;
 
     log_fp = stderr;
 
@@ -731,7 +1112,7 @@ main(int argc, char *argv[])
      * be optional.
      */
     while ((this_opt = getopt(argc, argv,
-			      "0123456789CDIKLNQR:TUVWace:fGgo:qrstvwx")) != -1) {
+			      "0123456789CDIKLNQR:TUVWace:fGgij:o:qrstvwx")) != -1) {
 	if (isdigit(this_opt)) {
 	    switch (last_opt) {
 	    case 'Q':
@@ -825,6 +1206,18 @@ main(int argc, char *argv[])
 	case 'g':
 	    numbers = -1;
 	    break;
+	case 'i':
+#if NCURSES_USE_DATABASE && !USE_HASHED_DB
+	    incremental = TRUE;
+#endif
+	    break;
+	case 'j':
+	    if ((tic_jobs = atoi(optarg)) < 1)
+		usage();
+#if !USE_TIC_JOBS
+	    tic_jobs = 1;
+#endif
+	    break;
 	case 'o':
 	    outdir = optarg;
 	    break;
@@ -961,7 +1354,7 @@ main(int argc, char *argv[])
 #endif /* HAVE_BIG_CORE */
     _nc_read_entry_source(tmp_fp, (char *) NULL,
 			  !smart_defaults || literal, FALSE,
-			  ((check_only || infodump || capdump)
+			  ((check_only || infodump || capdump || tic_jobs > 1)
 			   ? NULLHOOK
 			   : immedhook));
 
@@ -1006,9 +1399,17 @@ main(int argc, char *argv[])
     } else {
 	if (!infodump && !capdump) {
 	    _nc_set_writedir(outdir);
-	    for_entry_list(qp) {
-		if (matches(namelst, qp->tterm.term_names))
-		    write_it(qp);
+#if USE_TIC_JOBS
+	    if (tic_jobs > 1) {
+		parallel_written = write_parallel(tic_jobs);
+	    } else
+#endif
+	    {
+		for_entry_list(qp) {
+		    if (matches(namelst, qp->tterm.term_names)
+			&& must_write(qp))
+			write_it(qp);
+		}
 	    }
 	} else {
 	    /* this is in case infotocap() generates warnings */
@@ -1070,18 +1471,31 @@ main(int argc, char *argv[])
 	}
     }
 
+#if NCURSES_USE_DATABASE && !USE_HASHED_DB
+    if (incremental && !(check_only || infodump || capdump))
+	save_manifest();
+#endif
+
     /* Show the directory into which entries were written, and the total
      * number of entries
      */
     if (showsummary
 	&& (!(check_only || infodump || capdump))) {
-	int total = _nc_tic_written();
+	int total = (tic_jobs > 1) ? parallel_written : _nc_tic_written();
+#if NCURSES_USE_DATABASE && !USE_HASHED_DB
+	if (tic_jobs <= 1)
+	    total -= hashed;
+#endif
 	if (total != 0)
 	    fprintf(log_fp, "%d entries written to %s\n",
 		    total,
 		    _nc_tic_dir((char *) 0));
 	else
 	    fprintf(log_fp, "No entries written\n");
+#if NCURSES_USE_DATABASE && !USE_HASHED_DB
+	if (incremental)
+	    fprintf(log_fp, "%d entries unchanged\n", unchanged);
+#endif
     }
     ExitProgram(EXIT_SUCCESS);
 }
@@ -1,5 +1,5 @@
 /****************************************************************************
- * Copyright (c) 1998-2017,2018 Free Software Foundation, Inc.              *
+ * Copyright (c) 1998-2018,2020 Free Software Foundation, Inc.              *
  *                                                                          *
  * Permission is hereby granted, free of charge, to any person obtaining a  *
  * copy of this software and associated documentation files (the            *
@@ -61,6 +61,12 @@ static TERMDATA *ptr_termdata;	/* array of terminal data */
 static size_t use_termdata;	/* actual usage in ptr_termdata[] */
 static size_t len_termdata;	/* allocated size of ptr_termdata[] */
 
+#if NCURSES_USE_DATABASE
+static TERMDATA *ptr_leafdata;	/* entries of the current leaf directory */
+static size_t use_leafdata;	/* actual usage in ptr_leafdata[] */
+static size_t len_leafdata;	/* allocated size of ptr_leafdata[] */
+#endif
+
 #if NO_LEAKS
 #undef ExitProgram
 static void ExitProgram(int code) GCC_NORETURN;
@@ -202,6 +208,33 @@ free_termdata(void)
     len_termdata = 0;
 }
 
+#if NCURSES_USE_DATABASE
+static TERMDATA *
+new_leafdata(void)
+{
+    size_t want = use_leafdata + 1;
+
+    if (want >= len_leafdata) {
+	len_leafdata = (2 * want) + 10;
+	ptr_leafdata = typeRealloc(TERMDATA, len_leafdata, ptr_leafdata);
+	if (ptr_leafdata == 0)
+	    failed("ptr_leafdata");
+    }
+
+    return ptr_leafdata + use_leafdata++;
+}
+
+static void
+free_leafdata(void)
+{
+    while (use_leafdata != 0) {
+	--use_leafdata;
+	free(ptr_leafdata[use_leafdata].term_name);
+	free(ptr_leafdata[use_leafdata].description);
+    }
+}
+#endif
+
 static char **
 allocArgv(size_t count)
 {
@@ -252,7 +285,10 @@ make_db_name(char *dst, const char *src, unsigned limit)
 typedef void (DescHook) (int /* db_index */ ,
 			 int /* db_limit */ ,
 			 const char * /* term_name */ ,
-			 TERMTYPE2 * /* term */ );
+			 const char * /* description */ ,
+			 unsigned long /* checksum */ );
+
+static const char no_description[] = "(No description)";
 
 static const char *
 term_description(TERMTYPE2 *tp)
@@ -262,7 +298,7 @@ term_description(TERMTYPE2 *tp)
     if (tp->term_names == 0
 	|| (desc = strrchr(tp->term_names, '|')) == 0
 	|| (*++desc == '\0')) {
-	desc = "(No description)";
+	desc = no_description;
     }
 
     return desc;
@@ -270,59 +306,49 @@ term_description(TERMTYPE2 *tp)
 
 /* display a description for the type */
 static void
-deschook(int db_index, int db_limit, const char *term_name, TERMTYPE2 *tp)
+deschook(int db_index,
+	 int db_limit,
+	 const char *term_name,
+	 const char *description,
+	 unsigned long checksum)
 {
     (void) db_index;
     (void) db_limit;
-    (void) printf("%-10s\t%s\n", term_name, term_description(tp));
-}
-
-static unsigned long
-string_sum(const char *value)
-{
-    unsigned long result = 0;
-
-    if ((intptr_t) value == (intptr_t) (-1)) {
-	result = ~result;
-    } else if (value) {
-	while (*value) {
-	    result += UChar(*value);
-	    ++value;
-	}
-    }
-    return result;
-}
-
-static unsigned long
-checksum_of(TERMTYPE2 *tp)
-{
-    unsigned long result = string_sum(tp->term_names);
-    unsigned i;
-
-    for (i = 0; i < NUM_BOOLEANS(tp); i++) {
-	result += (unsigned long) (tp->Booleans[i]);
-    }
-    for (i = 0; i < NUM_NUMBERS(tp); i++) {
-	result += (unsigned long) (tp->Numbers[i]);
-    }
-    for (i = 0; i < NUM_STRINGS(tp); i++) {
-	result += string_sum(tp->Strings[i]);
-    }
-    return result;
+    (void) checksum;
+    (void) printf("%-10s\t%s\n", term_name, description);
 }
 
 /* collect data, to sort before display */
 static void
-sorthook(int db_index, int db_limit, const char *term_name, TERMTYPE2 *tp)
+sorthook(int db_index,
+	 int db_limit,
+	 const char *term_name,
+	 const char *description,
+	 unsigned long checksum)
 {
     TERMDATA *data = new_termdata();
 
     data->db_index = db_index;
-    data->checksum = ((db_limit > 1) ? checksum_of(tp) : 0);
+    data->checksum = ((db_limit > 1) ? checksum : 0);
     data->term_name = strmalloc(term_name);
-    data->description = strmalloc(term_description(tp));
+    data->description = strmalloc(description);
 }
 
+#if NCURSES_USE_DATABASE || NCURSES_USE_TERMCAP
+/* apply the hook to an entry which has been read */
+static void
+visit_entry(DescHook hook,
+	    int db_index,
+	    int db_limit,
+	    const char *term_name,
+	    TERMTYPE2 *tp)
+{
+    hook(db_index, db_limit, term_name,
+	 term_description(tp),
+	 ((db_limit > 1) ? _nc_entry_checksum(tp) : 0));
+}
+#endif
+
 #if NCURSES_USE_TERMCAP
 static void
 show_termcap(int db_index, int db_limit, char *buffer, DescHook hook)
@@ -343,7 +369,7 @@ show_termcap(int db_index, int db_limit, char *buffer, DescHook hook)
     data.term_names = strmalloc(buffer);
     while ((next = strtok(list, "|")) != 0) {
 	if (next != last)
-	    hook(db_index, db_limit, next, &data);
+	    visit_entry(hook, db_index, db_limit, next, &data);
 	list = 0;
     }
     free(data.term_names);
@@ -363,6 +389,124 @@ copy_entryname(DIRENT * src)
 
     return result;
 }
+
+#define isIndexname(name) !strncmp(name, DIR_INDEX, sizeof(DIR_INDEX) - 1)
+
+/*
+ * Collect the entries of the current directory from the index which tic keeps
+ * there.  Every file must have a record matching its size and modification
+ * time, otherwise we read the entries.
+ */
+static bool
+read_leaf_index(void)
+{
+    DIR_ENTRY *list;
+    size_t count;
+    bool result = FALSE;
+
+    if ((list = _nc_read_dir_index(DIR_INDEX, &count)) != 0) {
+	DIR *entrydir;
+	DIRENT *entry;
+
+	if ((entrydir = opendir(".")) != 0) {
+	    result = TRUE;
+	    while (result && (entry = readdir(entrydir)) != 0) {
+		DIR_ENTRY *found;
+		struct stat sb;
+		char *name_2 = copy_entryname(entry);
+
+		if (isDotname(name_2)
+		    || isIndexname(name_2)
+		    || stat(name_2, &sb) != 0
+		    || !S_ISREG(sb.st_mode)) {
+		    ;
+		} else if ((found = _nc_find_dir_entry(list, count, name_2,
+						       (long) sb.st_size,
+						       (long) sb.st_mtime))
+			   == 0) {
+		    result = FALSE;
+		} else if (found->description != 0) {
+		    TERMDATA *data = new_leafdata();
+
+		    data->checksum = found->checksum;
+		    data->term_name = strmalloc(found->name);
+		    data->description = strmalloc(*found->description
+						  ? found->description
+						  : no_description);
+		}
+		free(name_2);
+	    }
+	    closedir(entrydir);
+	}
+	_nc_free_dir_index(list, count);
+    }
+    if (!result)
+	free_leafdata();
+    return result;
+}
+
+/*
+ * Apply the hook to each entry in the current directory, using its index if
+ * that is up to date, and otherwise reading the entries.
+ */
+static void
+scan_leaf(int db_index, int db_limit, const char *leaf, DescHook hook)
+{
+    DIR *entrydir;
+    DIRENT *entry;
+    size_t n;
+
+    if (read_leaf_index()) {
+	for (n = 0; n < use_leafdata; ++n) {
+	    hook(db_index, db_limit,
+		 ptr_leafdata[n].term_name,
+		 ptr_leafdata[n].description,
+		 ((db_limit > 1) ? ptr_leafdata[n].checksum : 0));
+	}
+	free_leafdata();
+	return;
+    }
+
+    entrydir = opendir(".");
+    if (entrydir == 0) {
+	perror(leaf);
+	return;
+    }
+    while ((entry = readdir(entrydir)) != 0) {
+	char *name_2;
+	TERMTYPE2 lterm;
+	char *cn;
+	int status;
+
+	name_2 = copy_entryname(entry);
+	if (isDotname(name_2)
+	    || isIndexname(name_2)
+	    || !_nc_is_file_path(name_2)) {
+	    free(name_2);
+	    continue;
+	}
+
+	status = _nc_read_file_entry(name_2, &lterm);
+	if (status <= 0) {
+	    (void) fflush(stdout);
+	    (void) fprintf(stderr,
+			   "%s: couldn't open terminfo file %s.\n",
+			   _nc_progname, name_2);
+	    free(name_2);
+	    continue;
+	}
+
+	/* only visit things once, by primary name */
+	cn = _nc_first_name(lterm.term_names);
+	if (!strcmp(cn, name_2)) {
+	    /* apply the selected hook function */
+	    visit_entry(hook, db_index, db_limit, cn, &lterm);
+	}
+	_nc_free_termtype2(&lterm);
+	free(name_2);
+    }
+    closedir(entrydir);
+}
 #endif
 
 static int
@@ -394,8 +538,6 @@ typelist(int eargc, char *eargv[],
 	    while ((subdir = readdir(termdir)) != 0) {
 		size_t cwd_len;
 		char *name_1;
-		DIR *entrydir;
-		DIRENT *entry;
 
 		name_1 = copy_entryname(subdir);
 		if (isDotname(name_1)) {
@@ -417,43 +559,7 @@ typelist(int eargc, char *eargv[],
 		if (chdir(cwd_buf) != 0)
 		    continue;
 
-		entrydir = opendir(".");
-		if (entrydir == 0) {
-		    perror(cwd_buf);
-		    continue;
-		}
-		while ((entry = readdir(entrydir)) != 0) {
-		    char *name_2;
-		    TERMTYPE2 lterm;
-		    char *cn;
-		    int status;
-
-		    name_2 = copy_entryname(entry);
-		    if (isDotname(name_2) || !_nc_is_file_path(name_2)) {
-			free(name_2);
-			continue;
-		    }
-
-		    status = _nc_read_file_entry(name_2, &lterm);
-		    if (status <= 0) {
-			(void) fflush(stdout);
-			(void) fprintf(stderr,
-				       "%s: couldn't open terminfo file %s.\n",
-				       _nc_progname, name_2);
-			free(name_2);
-			continue;
-		    }
-
-		    /* only visit things once, by primary name */
-		    cn = _nc_first_name(lterm.term_names);
-		    if (!strcmp(cn, name_2)) {
-			/* apply the selected hook function */
-			hook(i, eargc, cn, &lterm);
-		    }
-		    _nc_free_termtype2(&lterm);
-		    free(name_2);
-		}
-		closedir(entrydir);
+		scan_leaf(i, eargc, cwd_buf, hook);
 	    }
 	    closedir(termdir);
 	    if (cwd_buf != 0)
@@ -485,7 +591,7 @@ typelist(int eargc, char *eargv[],
 				/* only visit things once, by primary name */
 				cn = _nc_first_name(lterm.term_names);
 				/* apply the selected hook function */
-				hook(i, eargc, cn, &lterm);
+				visit_entry(hook, i, eargc, cn, &lterm);
 				_nc_free_termtype2(&lterm);
 			    }
 			}
@@ -546,6 +652,14 @@ typelist(int eargc, char *eargv[],
 #endif
     }
 
+#if NCURSES_USE_DATABASE
+    if (ptr_leafdata != 0) {
+	free(ptr_leafdata);
+	ptr_leafdata = 0;
+	len_leafdata = 0;
+    }
+#endif
+
     if (hook == sorthook) {
 	show_termdata(eargc, eargv);
 	free_termdata();
@@ -60,6 +60,8 @@ static char *prg_name;
 static bool is_init = FALSE;
 static bool is_reset = FALSE;
 static bool is_clear = FALSE;
+static bool opt_serve = FALSE;	/* -s: report errors rather than exiting */
+static const char *num_format = "%d\n";
 
 static void
 quit(int status, const char *fmt,...)
@@ -85,6 +87,8 @@ usage(void)
 	KEEP("  -S <<       read commands from standard input")
 	KEEP("  -T TERM     use this instead of $TERM")
 	KEEP("  -V          print curses-version")
+	KEEP("  -s          serve commands from standard input, delimiting replies")
+	KEEP("  -t template expand the {capname parameters} in template")
 	KEEP("  -x          do not try to clear scrollback")
 	KEEP("")
 	KEEP("Commands:")
@@ -190,7 +194,7 @@ tput_cmd(int fd, TTY * saved_settings, bool opt_x, int argc, char *argv[])
     } else if ((status = tigetflag(name)) != -1) {
 	return exit_code(BOOLEAN, status);
     } else if ((status = tigetnum(name)) != CANCELLED_NUMERIC) {
-	(void) printf("%d\n", status);
+	(void) printf(num_format, status);
 	return exit_code(NUMBER, 0);
     } else if ((s = tigetstr(name)) == CANCELLED_STRING) {
 #if !PURE_TERMINFO
@@ -216,6 +220,11 @@ tput_cmd(int fd, TTY * saved_settings, bool opt_x, int argc, char *argv[])
 	    }
 	}
 #endif
+	if (opt_serve) {
+	    fprintf(stderr, "%s: unknown terminfo capability '%s'\n",
+		    prg_name, name);
+	    return ErrCapName;
+	}
 	quit(ErrCapName, "unknown terminfo capability '%s'", name);
     } else if (VALID_STRING(s)) {
 	if (argc > 1) {
@@ -274,6 +283,68 @@ tput_cmd(int fd, TTY * saved_settings, bool opt_x, int argc, char *argv[])
     return exit_code(STRING, 1);
 }
 
+/*
+ * Split a command into a dope vector, returning the number of words.
+ */
+static int
+split_args(char *buf, char **argvec, int limit)
+{
+    int argnum = 0;
+    char *cp;
+
+    for (cp = buf; *cp; cp++) {
+	if (isspace(UChar(*cp))) {
+	    *cp = '\0';
+	} else if (cp == buf || cp[-1] == 0) {
+	    argvec[argnum++] = cp;
+	    if (argnum >= limit - 1)
+		break;
+	}
+    }
+    argvec[argnum] = 0;
+    return argnum;
+}
+
+/*
+ * Copy the template to the standard output, replacing each "{command}" with
+ * the output of that command, and "{{" with "{".  Numbers are written
+ * without the trailing newline, so they can be embedded in the text.
+ */
+static int
+expand_template(int fd, TTY * saved_settings, bool opt_x, char *text)
+{
+    int result = 0;
+    char *cp;
+
+    num_format = "%d";
+    for (cp = text; *cp != '\0'; ++cp) {
+	char *argvec[16];	/* command, 9 parms, null, & slop */
+	char *mark;
+	int argnum;
+
+	if (*cp != '{') {
+	    putchar(UChar(*cp));
+	    continue;
+	}
+	if (cp[1] == '{') {
+	    putchar(UChar(*++cp));
+	    continue;
+	}
+	if ((mark = strchr(cp, '}')) == 0)
+	    quit(ErrUsage, "unterminated command in template: %s", cp);
+	*mark = '\0';
+	argnum = split_args(cp + 1, argvec, (int) SIZEOF(argvec));
+	if (argnum != 0
+	    && tput_cmd(fd, saved_settings, opt_x, argnum, argvec) != 0) {
+	    if (result == 0)
+		result = ErrSystem(0);	/* will return value >4 */
+	    ++result;
+	}
+	cp = mark;
+    }
+    return result;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -288,12 +359,13 @@ main(int argc, char **argv)
     bool opt_x = FALSE;		/* clear scrollback if possible */
     bool is_alias;
     bool need_tty;
+    char *opt_t = 0;		/* template to expand */
 
     prg_name = check_aliases(_nc_rootname(argv[0]), TRUE);
 
     term = getenv("TERM");
 
-    while ((c = getopt(argc, argv, "ST:Vx")) != -1) {
+    while ((c = getopt(argc, argv, "ST:Vst:x")) != -1) {
 	switch (c) {
 	case 'S':
 	    cmdline = FALSE;
@@ -306,6 +378,13 @@ main(int argc, char **argv)
 	case 'V':
 	    puts(curses_version());
 	    ExitProgram(EXIT_SUCCESS);
+	case 's':
+	    cmdline = FALSE;
+	    opt_serve = TRUE;
+	    break;
+	case 't':
+	    opt_t = optarg;
+	    break;
 	case 'x':		/* do not try to clear scrollback */
 	    opt_x = TRUE;
 	    break;
@@ -343,6 +422,12 @@ main(int argc, char **argv)
     if (setupterm(term, fd, &errret) != OK && errret <= 0)
 	quit(ErrTermType, "unknown terminal \"%s\"", term);
 
+    if (opt_t != 0) {
+	if (argc > 0 || !cmdline)
+	    usage();
+	ExitProgram(expand_template(fd, &tty_settings, opt_x, opt_t));
+    }
+
     if (cmdline) {
 	if ((argc <= 0) && !is_alias)
 	    usage();
@@ -351,23 +436,25 @@ main(int argc, char **argv)
 
     while (fgets(buf, sizeof(buf), stdin) != 0) {
 	char *argvec[16];	/* command, 9 parms, null, & slop */
-	int argnum = 0;
-	char *cp;
+	int argnum;
 
 	/* crack the argument list into a dope vector */
-	for (cp = buf; *cp; cp++) {
-	    if (isspace(UChar(*cp))) {
-		*cp = '\0';
-	    } else if (cp == buf || cp[-1] == 0) {
-		argvec[argnum++] = cp;
-		if (argnum >= (int) SIZEOF(argvec) - 1)
-		    break;
-	    }
-	}
-	argvec[argnum] = 0;
+	argnum = split_args(buf, argvec, (int) SIZEOF(argvec));
 
-	if (argnum != 0
-	    && tput_cmd(fd, &tty_settings, opt_x, argnum, argvec) != 0) {
+	if (opt_serve) {
+	    /*
+	     * Each reply is the command's output, a null, and its exit code
+	     * on a line by itself, flushed so that the client can read it
+	     * before sending the next command.
+	     */
+	    int status = 0;
+	    if (argnum != 0)
+		status = tput_cmd(fd, &tty_settings, opt_x, argnum, argvec);
+	    putchar('\0');
+	    printf("%d\n", status);
+	    fflush(stdout);
+	} else if (argnum != 0
+		   && tput_cmd(fd, &tty_settings, opt_x, argnum, argvec) != 0) {
 	    if (result == 0)
 		result = ErrSystem(0);	/* will return value >4 */
 	    ++result;